@@ -3,10 +3,19 @@ from ._cipells import (
     RealInterval, IndexInterval,
     RealBox, IndexBox,
     Identity, Translation, Jacobian, Affine,
-    Image,
+    Image, ImageLayout,
+    ImageStack, StackLayout,
+    MaskedImage,
+    ImageAllocator, ImageAllocationStats, setImageAllocator, getImageAllocator,
     Interpolant,
     Kernel,
-    Gaussian,
+    PixelType, MapAdvice, createImageFile, openImageFile, readImageFilePixelType, advise,
+    TiledImage, TileCacheStats, warp, convolve,
+    StreamingWarp,
+    ImageStatistics, ImageMoments, ClippedStatistics, computeStatistics, computeMoments,
+    computeClippedStatistics,
+    Gaussian, GaussianMixture, renderGaussians,
+    setThreadCount, getThreadCount,
 )
 import numpy as np
 
@@ -14,10 +23,20 @@ __all__ = ("Real", "Real2", "Index", "Index2",
            "RealInterval", "IndexInterval",
            "RealBox", "IndexBox",
            "Identity", "Translation", "Jacobian", "Affine",
-           "Image",
+           "Image", "ImageLayout",
+           "ImageStack", "StackLayout",
+           "MaskedImage",
+           "ImageAllocator", "ImageAllocationStats", "setImageAllocator", "getImageAllocator",
            "Interpolant",
            "Kernel",
-           "Gaussian",
+           "PixelType", "MapAdvice", "createImageFile", "openImageFile", "readImageFilePixelType",
+           "advise",
+           "TiledImage", "TileCacheStats", "warp", "convolve",
+           "StreamingWarp",
+           "ImageStatistics", "ImageMoments", "ClippedStatistics", "computeStatistics", "computeMoments",
+           "computeClippedStatistics",
+           "Gaussian", "GaussianMixture", "renderGaussians",
+           "setThreadCount", "getThreadCount",
            )
 
 Real = np.float64
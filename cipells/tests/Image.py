@@ -1,8 +1,10 @@
 import unittest
 import numpy as np
 
-from cipells import Image, IndexBox, Index2
-from cipells.tests import passImage, passImageToConst, passConstImage, testImageFreeze1, testImageFreeze2
+from cipells import Image, ImageLayout, IndexBox, Index2
+from cipells.tests import (passImage, passImageToConst, passConstImage, testImageFreeze1, testImageFreeze2,
+                           calibrateImage, calibrateImageInto, scaleRawImage, scaleRawImageLeft,
+                           scaleFloatImage)
 
 
 class ImageTestCase(unittest.TestCase):
@@ -72,6 +74,76 @@ class ImageTestCase(unittest.TestCase):
         self.assertEqual(array.dtype, np.dtype(np.complex64))
         self.checkImage(image, array, box)
 
+    def testOtherPixelTypes(self):
+        box = IndexBox(min=(1, 2), max=(5, 4))
+        for dtype in (np.float64, np.uint16, np.int32, np.float16):
+            image = Image(box, dtype=dtype)
+            self.assertEqual(image.dtype, np.dtype(dtype))
+            array = np.random.randint(0, 1000, size=(box.height, box.width)).astype(dtype)
+            self.checkImage(image, array, box)
+        with self.assertRaises(TypeError):
+            Image(box, dtype=np.int8)
+
+    def testPaddedImage(self):
+        box = IndexBox(min=(1, 2), max=(21, 6))
+        for dtype in (np.float32, np.complex64, np.float16):
+            image = Image(box, dtype=dtype, layout=ImageLayout.PADDED)
+            array = np.random.randn(box.height, box.width).astype(dtype)
+            self.checkImage(image, array, box)
+            self.assertEqual(image.array.ctypes.data % 64, 0)
+            self.assertEqual(image.array.strides[0] % 64, 0)
+            self.assertGreater(image.array.strides[0], box.width*image.array.itemsize)
+            copy = image.copy()
+            self.assertEqual(copy.array.ctypes.data % 64, 0)
+            self.assertEqual(copy.array.strides, image.array.strides)
+            subimage = image[IndexBox(min=(1, 3), max=(10, 5))]
+            self.assertEqual(subimage.array.strides, image.array.strides)
+
+    def testImageExpressions(self):
+        box = IndexBox(min=(-3, 2), max=(40, 30))
+        raw = Image(box, dtype=np.uint16)
+        raw.array = np.random.randint(1000, 2000, size=raw.array.shape)
+        bias = Image(box, dtype=np.float32)
+        bias.array = np.random.randn(*bias.array.shape)
+        flat = Image(box, dtype=np.float32, layout=ImageLayout.PADDED)
+        flat.array = np.random.uniform(0.9, 1.1, size=flat.array.shape)
+        gain = 2.5
+        expected = ((raw.array.astype(np.float32) - bias.array)*np.float32(gain)/flat.array)
+        result = calibrateImage(raw, bias, flat, gain)
+        self.assertEqual(result.bbox, box)
+        np.testing.assert_allclose(result.array, expected, rtol=1E-6)
+        # Operands with different bounding boxes use their intersection.
+        subbox = IndexBox(min=(0, 5), max=(20, 25))
+        result = calibrateImage(raw[subbox], bias, flat[box.erodedBy(1)], gain)
+        self.assertEqual(result.bbox, subbox)
+        sub = subbox.shiftedBy(-box.min)
+        np.testing.assert_allclose(result.array, expected[sub.y.slice, sub.x.slice], rtol=1E-6)
+        # Pixels of the output outside the expression are left alone.
+        output = Image(box.dilatedBy(2), dtype=np.float32)
+        output.array = -1.0
+        calibrateImageInto(output, raw[subbox], bias, flat, gain)
+        sub = subbox.shiftedBy(-output.bbox.min)
+        np.testing.assert_allclose(output.array[sub.y.slice, sub.x.slice], result.array, rtol=1E-6)
+        self.assertEqual((output.array == -1.0).sum(), output.array.size - result.array.size)
+
+    def testScalarPromotion(self):
+        # Integer images combined with floating-point scalars are promoted
+        # (as in NumPy) instead of truncating the scalar; floating-point
+        # images keep their own type.
+        box = IndexBox(min=(-2, 3), max=(12, 10))
+        raw = Image(box, dtype=np.uint16)
+        raw.array = np.random.randint(0, 60000, size=raw.array.shape)
+        for func in (scaleRawImage, scaleRawImageLeft):
+            result = func(raw, 2.5)
+            self.assertEqual(result.dtype, np.float64)
+            self.assertEqual(result.bbox, box)
+            np.testing.assert_array_equal(result.array, raw.array.astype(np.float64)*2.5)
+        image = Image(box, dtype=np.float32)
+        image.array = np.random.randn(*image.array.shape)
+        result = scaleFloatImage(image, 0.1)
+        self.assertEqual(result.dtype, np.float32)
+        np.testing.assert_array_equal(result.array, image.array*np.float32(0.1))
+
 
 if __name__ == "__main__":
     unittest.main()
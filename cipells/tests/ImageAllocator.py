@@ -0,0 +1,60 @@
+import unittest
+import numpy as np
+
+from cipells import Image, IndexBox, ImageAllocator, setImageAllocator, getImageAllocator
+
+
+class ImageAllocatorTestCase(unittest.TestCase):
+
+    def tearDown(self):
+        setImageAllocator(None)
+
+    def testPool(self):
+        pool = ImageAllocator.makePool()
+        setImageAllocator(pool)
+        self.assertIs(getImageAllocator(), pool)
+        box = IndexBox(min=(0, 0), max=(99, 49))
+        for n in range(10):
+            image = Image(box, dtype=np.float32)
+            np.testing.assert_array_equal(image.array, 0.0)
+            self.assertEqual(image.array.ctypes.data % 64, 0)
+            image.array = n
+            del image
+        stats = pool.stats
+        self.assertEqual(stats.allocations, 10)
+        self.assertEqual(stats.reused, 9)
+        self.assertEqual(stats.bytesInUse, 0)
+        self.assertGreaterEqual(stats.bytesCached, 100*50*4)
+        self.assertLessEqual(stats.bytesCached, 100*50*5)
+        pool.trim()
+        self.assertEqual(pool.stats.bytesCached, 0)
+
+    def testHeap(self):
+        heap = ImageAllocator.makeHeap()
+        setImageAllocator(heap)
+        image = Image(IndexBox(min=(0, 0), max=(9, 9)), dtype=np.complex64)
+        self.assertEqual(image.array.ctypes.data % 64, 0)
+        self.assertEqual(heap.stats.allocations, 1)
+        self.assertEqual(heap.stats.bytesInUse, 10*10*8)
+        del image
+        stats = heap.stats
+        self.assertEqual(stats.reused, 0)
+        self.assertEqual(stats.bytesInUse, 0)
+        self.assertEqual(stats.bytesCached, 0)
+
+    def testDefault(self):
+        # The default allocator must not hold on to released storage.
+        setImageAllocator(None)
+        allocator = getImageAllocator()
+        box = IndexBox(min=(0, 0), max=(99, 49))
+        for n in range(3):
+            image = Image(box, dtype=np.float32)
+            del image
+        stats = allocator.stats
+        self.assertEqual(stats.allocations, 3)
+        self.assertEqual(stats.reused, 0)
+        self.assertEqual(stats.bytesCached, 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
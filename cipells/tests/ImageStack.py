@@ -0,0 +1,87 @@
+import unittest
+import numpy as np
+
+from cipells import Image, ImageStack, StackLayout, IndexBox, Affine, Translation, Interpolant, Kernel
+
+
+class ImageStackTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.rng = np.random.RandomState(19)
+        self.box = IndexBox(min=(-7, 3), max=(60, 50))
+        self.outputBox = IndexBox(min=(0, 5), max=(55, 45))
+        self.planes = []
+        for n in range(3):
+            image = Image(self.box, dtype=np.float32)
+            image.array = self.rng.randn(*image.array.shape)
+            self.planes.append(image)
+        self.transforms = [
+            Affine(np.array([[0.95, 0.3], [-0.3, 0.95]]), np.array([0.4, 2.2])),
+            Translation(np.array([0.3, -1.7])),
+        ]
+
+    def makeStack(self, layout):
+        stack = ImageStack(self.box, len(self.planes), layout=layout)
+        for n, plane in enumerate(self.planes):
+            stack.setPlane(n, plane)
+        return stack
+
+    def testLayouts(self):
+        for layout in (StackLayout.PLANAR, StackLayout.INTERLEAVED):
+            stack = self.makeStack(layout)
+            self.assertEqual(stack.bbox, self.box)
+            self.assertEqual(stack.planeCount, 3)
+            self.assertEqual(stack.layout, layout)
+            self.assertEqual(stack.array.shape, (3, self.box.height, self.box.width))
+            for n, plane in enumerate(self.planes):
+                np.testing.assert_array_equal(stack.array[n], plane.array)
+                np.testing.assert_array_equal(stack.copyPlane(n).array, plane.array)
+            subbox = IndexBox(min=(0, 10), max=(20, 30))
+            substack = stack[subbox]
+            substack.array[1] = 5.0
+            sub = subbox.shiftedBy(-self.box.min)
+            np.testing.assert_array_equal(stack.array[1][sub.y.slice, sub.x.slice], 5.0)
+            with self.assertRaises(IndexError):
+                stack.copyPlane(3)
+
+    def testWarp(self):
+        # The sinc interpolant warps by the translation in Fourier space, and
+        # must do so for stacks just as it does for images.
+        for interpolant in (Interpolant.lanczos(3), Interpolant.sinc):
+            for inLayout in (StackLayout.PLANAR, StackLayout.INTERLEAVED):
+                for outLayout in (StackLayout.PLANAR, StackLayout.INTERLEAVED):
+                    input = self.makeStack(inLayout)
+                    output = ImageStack(self.outputBox, len(self.planes), layout=outLayout)
+                    for transform in self.transforms:
+                        interpolant.warp(input, transform, output)
+                        for n, plane in enumerate(self.planes):
+                            expected = Image(self.outputBox, dtype=np.float32)
+                            interpolant.warp(plane, transform, expected)
+                            np.testing.assert_allclose(output.array[n], expected.array, rtol=0, atol=1E-5)
+
+    def testConvolve(self):
+        image = Image(IndexBox(min=(-4, -4), max=(4, 4)), dtype=np.float32)
+        x, y = image.bbox.meshgrid()
+        image.array = np.exp(-0.1*(x**2 + y**2 + 0.3*x*y))
+        kernel = Kernel(image, upsampling=2).decompose(1E-3)
+        for layout in (StackLayout.PLANAR, StackLayout.INTERLEAVED):
+            input = self.makeStack(layout)
+            output = ImageStack(self.outputBox, len(self.planes))
+            for mode in (Kernel.ConvolutionMode.DIRECT, Kernel.ConvolutionMode.FFT,
+                         Kernel.ConvolutionMode.SEPARABLE):
+                for method in ("convolve", "correlate"):
+                    getattr(kernel, method)(input, self.transforms[0], output, mode=mode)
+                    for n, plane in enumerate(self.planes):
+                        expected = Image(self.outputBox, dtype=np.float32)
+                        getattr(kernel, method)(plane, self.transforms[0], expected, mode=mode)
+                        np.testing.assert_allclose(output.array[n], expected.array, rtol=0, atol=1E-5)
+
+    def testMismatchedPlanes(self):
+        input = self.makeStack(StackLayout.PLANAR)
+        output = ImageStack(self.outputBox, 2)
+        with self.assertRaises(ValueError):
+            Interpolant.cubic.warp(input, self.transforms[0], output)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -1,7 +1,7 @@
 import unittest
 import numpy as np
 
-from cipells import Interpolant
+from cipells import Interpolant, Image, IndexBox, Translation, Jacobian, Affine
 
 
 class InterpolantTestCase(unittest.TestCase):
@@ -20,6 +20,19 @@ class InterpolantTestCase(unittest.TestCase):
         np.testing.assert_array_equal(Interpolant.quintic(np.linspace(3, 6, 10)), 0)
         np.testing.assert_array_equal(Interpolant.quintic(np.linspace(-3, -6, 10)), 0)
 
+    def testLanczosNodes(self):
+        for order in (3, 4, 5):
+            lanczos = Interpolant.lanczos(order)
+            self.assertEqual(lanczos.radius, order)
+            self.assertEqual(lanczos(0.0), 1.0)
+            np.testing.assert_allclose(lanczos(np.arange(-order, order + 1, 1)[np.arange(2*order + 1) != order]),
+                                       0, atol=1E-15)
+            np.testing.assert_array_equal(lanczos(np.linspace(order, order + 3, 10)), 0)
+            x = np.linspace(-order + 0.01, order - 0.01, 99)
+            np.testing.assert_allclose(lanczos(x), np.sinc(x)*np.sinc(x/order), rtol=1E-12, atol=1E-15)
+        with self.assertRaises(ValueError):
+            Interpolant.lanczos(2)
+
     def testSincNodes(self):
         self.assertEqual(Interpolant.sinc(0.0), 1.0)
         np.testing.assert_allclose(Interpolant.sinc(np.arange(1, 10, 1)), 0, atol=1E-16)
@@ -77,6 +90,104 @@ class InterpolantTestCase(unittest.TestCase):
             rtol=1E-2
         )
 
+    def testEvaluate(self):
+        x = np.linspace(-4, 4, 1003).reshape(17, 59)
+        for interpolant in (Interpolant.cubic, Interpolant.quintic, Interpolant.sinc,
+                            Interpolant.tabulate(Interpolant.cubic)):
+            y = interpolant.evaluate(x)
+            self.assertEqual(y.dtype, np.float32)
+            self.assertEqual(y.shape, x.shape)
+            np.testing.assert_allclose(y, interpolant(x), rtol=0, atol=1E-6)
+
+    def testWarpGeneral(self):
+        for order in (3, 4, 5):
+            self.checkWarp(Interpolant.lanczos(order),
+                           Affine(np.array([[1.1, 0.2], [-0.1, 0.9]]), np.array([0.4, 0.25])),
+                           rtol=1E-5)
+
+    def testSincFourierWarp(self):
+        input = Image(IndexBox(min=(-3, 2), max=(27, 22)), dtype=np.float32)
+        input.array = np.random.randn(*input.array.shape)
+        output = Image(input.bbox, dtype=np.float32)
+        # Integer translations just roll the (periodic) image.
+        Interpolant.sinc.warp(input, Translation(np.array([3.0, -2.0])), output)
+        np.testing.assert_allclose(output.array, np.roll(input.array, (2, -3), axis=(0, 1)),
+                                   rtol=1E-5, atol=1E-5)
+        # warpDirect never uses the Fourier path, so it zero-pads instead.
+        Interpolant.sinc.warpDirect(input, Translation(np.array([3.0, -2.0])), output)
+        expected = np.zeros(input.array.shape)
+        expected[2:, :-3] = input.array[:-2, 3:]
+        np.testing.assert_allclose(output.array, expected, rtol=1E-5, atol=1E-5)
+        # Subpixel translations apply a phase ramp.
+        shift = np.array([0.3, -1.7])
+        Interpolant.sinc.warp(input, Translation(shift), output)
+        ky = np.fft.fftfreq(input.bbox.height)
+        kx = np.fft.fftfreq(input.bbox.width)
+        ramp = np.exp(2j*np.pi*np.add.outer(ky*shift[1], kx*shift[0]))
+        np.testing.assert_allclose(output.array, np.fft.ifft2(np.fft.fft2(input.array)*ramp).real,
+                                   rtol=1E-5, atol=1E-5)
+        # Upsampling by an integer factor reproduces the input at every
+        # second pixel.
+        upsampled = Image(IndexBox(min=(-6, 4), max=(55, 45)), dtype=np.float32)
+        Interpolant.sinc.warp(input, Jacobian(np.diag([0.5, 0.5])), upsampled)
+        np.testing.assert_allclose(upsampled.array[::2, ::2], input.array, rtol=1E-5, atol=1E-5)
+
+    def testTabulated(self):
+        x = np.linspace(-4, 4, 1001)
+        for exact in (Interpolant.cubic, Interpolant.quintic):
+            nearest = Interpolant.tabulate(exact, phases=1024)
+            blended = Interpolant.tabulate(exact, phases=1024, blend=True)
+            self.assertEqual(nearest.radius, exact.radius)
+            self.assertEqual(exact.maxError, 0.0)
+            self.assertLess(nearest.maxError, 1E-3)
+            self.assertLess(blended.maxError, nearest.maxError)
+            np.testing.assert_array_less(np.abs(nearest(x) - exact(x)), nearest.maxError*1.01)
+            np.testing.assert_array_less(np.abs(blended(x) - exact(x)), blended.maxError*1.01)
+            self.checkWarp(blended, Affine(np.array([[1.1, 0.2], [-0.1, 0.9]]), np.array([0.4, 0.25])),
+                           rtol=1E-5)
+        with self.assertRaises(ValueError):
+            Interpolant.tabulate(Interpolant.sinc)
+
+    def checkWarp(self, interpolant, transform, rtol):
+        input = Image(IndexBox(min=(-3, 2), max=(30, 27)), dtype=np.float32)
+        input.array = np.random.randn(*input.array.shape)
+        output = Image(IndexBox(min=(0, 5), max=(35, 28)), dtype=np.float32)
+        interpolant.warp(input, transform, output)
+        x, y = transform(*output.bbox.meshgrid(dtype=float))
+        wx = interpolant(np.subtract.outer(x[0, :], input.bbox.x.arange(dtype=float)))
+        wy = interpolant(np.subtract.outer(y[:, 0], input.bbox.y.arange(dtype=float)))
+        np.testing.assert_allclose(output.array, np.dot(wy, np.dot(input.array, wx.transpose())),
+                                   rtol=rtol, atol=rtol)
+
+    def testWarpSeparable(self):
+        for interpolant in (Interpolant.cubic, Interpolant.quintic, Interpolant.lanczos(3)):
+            self.checkWarp(interpolant, Translation(np.array([0.3, -1.7])), rtol=1E-5)
+            self.checkWarp(interpolant, Affine(Jacobian(np.diag([0.7, 1.3])), Translation(np.array([0.5, 2.5]))),
+                           rtol=1E-5)
+
+    def testWarpConvertedInput(self):
+        input = Image(IndexBox(min=(-3, 2), max=(30, 27)), dtype=np.float32)
+        input.array = np.random.randint(0, 2000, size=input.array.shape)
+        transform = Affine(np.array([[1.1, 0.2], [-0.1, 0.9]]), np.array([0.4, 0.25]))
+        expected = Image(IndexBox(min=(0, 5), max=(35, 28)), dtype=np.float32)
+        Interpolant.lanczos(3).warp(input, transform, expected)
+        for dtype in (np.uint16, np.float16):
+            converted = Image(input.bbox, dtype=dtype)
+            converted.array = input.array
+            output = Image(expected.bbox, dtype=np.float32)
+            Interpolant.lanczos(3).warp(converted, transform, output)
+            np.testing.assert_allclose(output.array, expected.array, rtol=1E-6, atol=1E-3)
+        # Converted inputs take the sinc interpolant's Fourier-space path too.
+        shift = Translation(np.array([0.3, -1.7]))
+        expected = Image(input.bbox, dtype=np.float32)
+        Interpolant.sinc.warp(input, shift, expected)
+        for dtype in (np.uint16, np.float16):
+            converted = Image(input.bbox, dtype=dtype)
+            converted.array = input.array
+            output = Image(input.bbox, dtype=np.float32)
+            Interpolant.sinc.warp(converted, shift, output)
+            np.testing.assert_allclose(output.array, expected.array, rtol=1E-5, atol=1E-2)
+
 
 if __name__ == "__main__":
     unittest.main()
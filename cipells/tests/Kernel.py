@@ -0,0 +1,147 @@
+import unittest
+import numpy as np
+
+from cipells import Image, IndexBox, Index2, Identity, Translation, Affine, Kernel, Interpolant
+
+
+def convolveDirect(array, kernel, upsampling=1):
+    """Convolve with a kernel at integer offsets, using only the kernel pixels
+    that fall on the input grid (the exact result for integer translations).
+    """
+    hy, hx = (np.array(kernel.shape) - 1)//2
+    result = np.zeros(array.shape, dtype=np.float64)
+    for jy in range(-(hy//upsampling), hy//upsampling + 1):
+        for jx in range(-(hx//upsampling), hx//upsampling + 1):
+            shifted = np.zeros(array.shape, dtype=np.float64)
+            shifted[max(jy, 0):array.shape[0] + min(jy, 0), max(jx, 0):array.shape[1] + min(jx, 0)] = \
+                array[max(-jy, 0):array.shape[0] + min(-jy, 0), max(-jx, 0):array.shape[1] + min(-jx, 0)]
+            result += kernel[hy + upsampling*jy, hx + upsampling*jx]*shifted
+    return result*upsampling**2
+
+
+class KernelTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.rng = np.random.RandomState(50)
+        self.input = Image(IndexBox(min=(-3, 2), max=(45, 50)), dtype=np.float32)
+        self.input.array = self.rng.randn(*self.input.array.shape)
+
+    def makeKernel(self, upsampling):
+        image = Image(IndexBox(min=(-6, -4), max=(6, 4)), dtype=np.float32)
+        image.array = self.rng.randn(*image.array.shape)
+        return Kernel(image, upsampling=upsampling, interpolant=Interpolant.cubic)
+
+    def testConvolveIdentity(self):
+        for upsampling in (1, 2):
+            kernel = self.makeKernel(upsampling)
+            output = kernel.convolve(self.input)
+            self.assertEqual(output.bbox, self.input.bbox)
+            np.testing.assert_allclose(
+                output.array,
+                convolveDirect(self.input.array, kernel.image.array, upsampling),
+                rtol=1E-5, atol=1E-5
+            )
+
+    def testCorrelateIdentity(self):
+        kernel = self.makeKernel(2)
+        output = kernel.correlate(self.input)
+        np.testing.assert_allclose(
+            output.array,
+            convolveDirect(self.input.array, kernel.image.array[::-1, ::-1], 2),
+            rtol=1E-5, atol=1E-5
+        )
+
+    def testConvolveIntegerTranslation(self):
+        kernel = self.makeKernel(1)
+        shift = Index2(3, -2)
+        output = Image(self.input.bbox.shiftedBy(shift), dtype=np.float32)
+        kernel.convolve(self.input, Translation(np.array([shift.x, shift.y], dtype=float)), output)
+        np.testing.assert_allclose(
+            output.array,
+            convolveDirect(self.input.array, kernel.image.array),
+            rtol=1E-5, atol=1E-5
+        )
+
+    def testConvolutionModes(self):
+        transform = Affine(np.array([[0.95, 0.3], [-0.3, 0.95]]), np.array([0.4, 0.2]))
+        for upsampling in (1, 2, 3):
+            kernel = self.makeKernel(upsampling)
+            for method in (kernel.convolve, kernel.correlate):
+                direct = Image(self.input.bbox, dtype=np.float32)
+                fft = Image(self.input.bbox, dtype=np.float32)
+                method(self.input, transform, direct, mode=Kernel.ConvolutionMode.DIRECT)
+                method(self.input, transform, fft, mode=Kernel.ConvolutionMode.FFT)
+                np.testing.assert_allclose(fft.array, direct.array, rtol=1E-5, atol=1E-5)
+        large = Kernel(Image(IndexBox(min=(-20, -20), max=(20, 20)), dtype=np.float32))
+        self.assertEqual(large.chooseConvolutionMode(), Kernel.ConvolutionMode.FFT)
+
+    def testTiledConvolutionModes(self):
+        # Outputs larger than one tile of the FFT and SEPARABLE modes'
+        # intermediate images.
+        input = Image(IndexBox(min=(-7, 3), max=(292, 262)), dtype=np.float32)
+        input.array = self.rng.randn(*input.array.shape)
+        transform = Affine(np.array([[0.95, 0.3], [-0.3, 0.95]]), np.array([0.4, 0.2]))
+        kernel = self.makeKernel(2).decompose(0.0)
+        direct = Image(input.bbox, dtype=np.float32)
+        kernel.convolve(input, transform, direct, mode=Kernel.ConvolutionMode.DIRECT)
+        for mode in (Kernel.ConvolutionMode.FFT, Kernel.ConvolutionMode.SEPARABLE):
+            output = Image(input.bbox, dtype=np.float32)
+            kernel.convolve(input, transform, output, mode=mode)
+            np.testing.assert_allclose(output.array, direct.array, rtol=1E-5, atol=1E-5)
+
+    def testSincConvolutionModes(self):
+        # With the sinc interpolant, the final warp of an identity or
+        # integer-translation convolution is one the sinc interpolant can do
+        # in Fourier space, but every mode must zero-pad like DIRECT mode.
+        image = Image(IndexBox(min=(-4, -4), max=(4, 4)), dtype=np.float32)
+        image.array = self.rng.randn(*image.array.shape)
+        for upsampling in (1, 2):
+            kernel = Kernel(image, upsampling=upsampling, interpolant=Interpolant.sinc).decompose(0.0)
+            for transform in (Identity(), Translation(np.array([3.0, -2.0]))):
+                direct = Image(self.input.bbox, dtype=np.float32)
+                kernel.convolve(self.input, transform, direct, mode=Kernel.ConvolutionMode.DIRECT)
+                for mode in (Kernel.ConvolutionMode.FFT, Kernel.ConvolutionMode.SEPARABLE):
+                    output = Image(self.input.bbox, dtype=np.float32)
+                    kernel.convolve(self.input, transform, output, mode=mode)
+                    np.testing.assert_allclose(output.array, direct.array, rtol=1E-5, atol=1E-4)
+
+    def testSeparable(self):
+        kernel = self.makeKernel(2)
+        exact = kernel.decompose(0.0)
+        self.assertEqual(exact.separableRank, 9)
+        self.assertLess(exact.separableResidual, 1E-5)
+        np.testing.assert_allclose(exact.image.array, kernel.image.array, rtol=1E-5, atol=1E-5)
+        approx = kernel.decompose(0.5)
+        self.assertLess(approx.separableRank, 9)
+        self.assertLessEqual(approx.separableResidual, 0.5)
+        self.assertEqual(kernel.separableRank, 0)
+        transform = Affine(np.array([[0.95, 0.3], [-0.3, 0.95]]), np.array([0.4, 0.2]))
+        for method in (approx.convolve, approx.correlate):
+            direct = Image(self.input.bbox, dtype=np.float32)
+            separable = Image(self.input.bbox, dtype=np.float32)
+            method(self.input, transform, direct, mode=Kernel.ConvolutionMode.DIRECT)
+            method(self.input, transform, separable, mode=Kernel.ConvolutionMode.SEPARABLE)
+            np.testing.assert_allclose(separable.array, direct.array, rtol=1E-5, atol=1E-5)
+        with self.assertRaises(ValueError):
+            kernel.convolve(self.input, mode=Kernel.ConvolutionMode.SEPARABLE)
+
+    def testConvertedInput(self):
+        kernel = self.makeKernel(2).decompose(0.0)
+        transform = Affine(np.array([[0.95, 0.3], [-0.3, 0.95]]), np.array([0.4, 0.2]))
+        input = Image(self.input.bbox, dtype=np.float32)
+        input.array = self.rng.randint(0, 2000, size=input.array.shape)
+        for dtype in (np.uint16, np.float16):
+            converted = Image(input.bbox, dtype=dtype)
+            converted.array = input.array
+            for mode in (Kernel.ConvolutionMode.DIRECT, Kernel.ConvolutionMode.FFT,
+                         Kernel.ConvolutionMode.SEPARABLE):
+                for method in (kernel.convolve, kernel.correlate):
+                    expected = Image(input.bbox, dtype=np.float32)
+                    output = Image(input.bbox, dtype=np.float32)
+                    method(input, transform, expected, mode=mode)
+                    method(converted, transform, output, mode=mode)
+                    np.testing.assert_allclose(output.array, expected.array, rtol=1E-5, atol=1E-3)
+
+
+if __name__ == "__main__":
+    unittest.main()
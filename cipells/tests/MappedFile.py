@@ -0,0 +1,77 @@
+import os
+import tempfile
+import unittest
+import numpy as np
+
+from cipells import (IndexBox, Image, ImageLayout, PixelType, MapAdvice, createImageFile, openImageFile,
+                     readImageFilePixelType, advise)
+
+
+class MappedFileTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+        self.box = IndexBox(min=(-3, 2), max=(40, 30))
+        self.rng = np.random.RandomState(50)
+
+    def tearDown(self):
+        self.dir.cleanup()
+
+    def testRoundTrip(self):
+        path = os.path.join(self.dir.name, "image.cip")
+        for layout in (ImageLayout.COMPACT, ImageLayout.PADDED):
+            image = createImageFile(path, self.box, dtype=np.float32, layout=layout)
+            self.assertEqual(image.bbox, self.box)
+            np.testing.assert_array_equal(image.array, 0.0)
+            data = self.rng.randn(self.box.height, self.box.width).astype(np.float32)
+            image.array = data
+            del image
+            self.assertEqual(readImageFilePixelType(path), PixelType.FLOAT32)
+            loaded = openImageFile(path)
+            self.assertEqual(loaded.bbox, self.box)
+            self.assertEqual(loaded.dtype, np.float32)
+            self.assertFalse(loaded.array.flags.writeable)
+            np.testing.assert_array_equal(loaded.array, data)
+            if layout == ImageLayout.PADDED:
+                self.assertEqual(loaded.array.strides[0] % 64, 0)
+            sub = IndexBox(min=(0, 5), max=(10, 12))
+            np.testing.assert_array_equal(loaded[sub].array, data[sub.y.min - 2:sub.y.max - 1,
+                                                                  sub.x.min + 3:sub.x.max + 4])
+            advise(loaded, MapAdvice.SEQUENTIAL)
+            advise(loaded[sub], MapAdvice.WILLNEED)
+
+    def testWritable(self):
+        path = os.path.join(self.dir.name, "image.cip")
+        image = createImageFile(path, self.box, dtype=np.complex64)
+        del image
+        image = openImageFile(path, writable=True)
+        self.assertEqual(image.dtype, np.complex64)
+        image[self.box.min] = 2.0 + 1.0j
+        del image
+        self.assertEqual(openImageFile(path)[self.box.min], 2.0 + 1.0j)
+
+    def testPixelTypes(self):
+        path = os.path.join(self.dir.name, "image.cip")
+        for dtype, pixelType in ((np.float64, PixelType.FLOAT64), (np.uint16, PixelType.UINT16),
+                                 (np.int32, PixelType.INT32), (np.float16, PixelType.FLOAT16)):
+            data = self.rng.randint(0, 1000, size=(self.box.height, self.box.width)).astype(dtype)
+            image = createImageFile(path, self.box, dtype=dtype)
+            image.array = data
+            del image
+            self.assertEqual(readImageFilePixelType(path), pixelType)
+            loaded = openImageFile(path)
+            self.assertEqual(loaded.dtype, np.dtype(dtype))
+            np.testing.assert_array_equal(loaded.array, data)
+
+    def testErrors(self):
+        path = os.path.join(self.dir.name, "bad.cip")
+        with open(path, "wb") as stream:
+            stream.write(b"not an image file" * 8)
+        with self.assertRaises(RuntimeError):
+            openImageFile(path)
+        with self.assertRaises(RuntimeError):
+            openImageFile(os.path.join(self.dir.name, "missing.cip"))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,105 @@
+import unittest
+import numpy as np
+
+from cipells import Image, MaskedImage, IndexBox, Affine, Translation, Interpolant, Kernel
+
+
+class MaskedImageTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.rng = np.random.RandomState(20)
+        self.input = MaskedImage(IndexBox(min=(-7, 3), max=(53, 59)))
+        self.input.image.array = self.rng.randn(*self.input.image.array.shape)
+        self.input.variance.array = self.rng.uniform(1.0, 2.0, size=self.input.variance.array.shape)
+        self.input.mask[20, 30] = 0x4
+        self.input.mask[21, 30] = 0x1
+        self.outputBox = IndexBox(min=(0, 5), max=(49, 49))
+        self.affine = Affine(np.array([[0.95, 0.3], [-0.3, 0.95]]), np.array([0.4, 2.2]))
+
+    def testConstruction(self):
+        box = IndexBox(min=(1, 2), max=(5, 4))
+        masked = MaskedImage(box)
+        self.assertEqual(masked.bbox, box)
+        self.assertEqual(masked.image.dtype, np.float32)
+        self.assertEqual(masked.mask.dtype, np.int32)
+        self.assertEqual(masked.variance.dtype, np.float32)
+        view = MaskedImage(masked.image, masked.mask, masked.variance)
+        view.image.array = 3.0
+        np.testing.assert_array_equal(masked.image.array, 3.0)
+        subbox = IndexBox(min=(2, 3), max=(4, 4))
+        self.assertEqual(masked[subbox].bbox, subbox)
+        with self.assertRaises(ValueError):
+            MaskedImage(masked.image, masked.mask, Image(subbox, dtype=np.float32))
+
+    def testWarpTranslation(self):
+        # For translations we can compute the expected variance and mask
+        # directly from the separable weights.
+        shift = np.array([0.3, 0.6])
+        interpolant = Interpolant.lanczos(3)
+        output = MaskedImage(self.outputBox)
+        interpolant.warp(self.input, Translation(shift), output)
+        expected = Image(self.outputBox, dtype=np.float32)
+        interpolant.warp(self.input.image, Translation(shift), expected)
+        np.testing.assert_allclose(output.image.array, expected.array, rtol=0, atol=1E-6)
+        ix = self.input.bbox.x.arange(np.float64)
+        iy = self.input.bbox.y.arange(np.float64)
+        wx = interpolant(self.outputBox.x.arange(np.float64)[:, np.newaxis] + shift[0] - ix[np.newaxis, :])
+        wy = interpolant(self.outputBox.y.arange(np.float64)[:, np.newaxis] + shift[1] - iy[np.newaxis, :])
+        variance = np.dot(wy**2, np.dot(self.input.variance.array, (wx**2).T))
+        np.testing.assert_allclose(output.variance.array, variance, rtol=1E-5)
+        mask = np.zeros(output.mask.array.shape, dtype=np.int32)
+        for bit in (0x4, 0x1):
+            hit = np.dot(wy != 0, np.dot(self.input.mask.array & bit != 0, (wx != 0).T)) > 0
+            mask[hit] |= bit
+        np.testing.assert_array_equal(output.mask.array, mask)
+
+    def testWarpAffine(self):
+        output = MaskedImage(self.outputBox)
+        Interpolant.cubic.warp(self.input, self.affine, output)
+        expected = Image(self.outputBox, dtype=np.float32)
+        Interpolant.cubic.warp(self.input.image, self.affine, expected)
+        np.testing.assert_allclose(output.image.array, expected.array, rtol=0, atol=1E-5)
+        self.assertTrue((output.variance.array > 0).all())
+        self.assertEqual(set(np.unique(output.mask.array)), {0, 0x1, 0x4, 0x5})
+
+    def testConvolve(self):
+        image = Image(IndexBox(min=(-3, -3), max=(3, 3)), dtype=np.float32)
+        x, y = image.bbox.meshgrid()
+        image.array = np.exp(-0.3*(x**2 + y**2 + 0.3*x*y))
+        kernel = Kernel(image, upsampling=2).decompose(1E-3)
+        results = []
+        for mode in (Kernel.ConvolutionMode.DIRECT, Kernel.ConvolutionMode.FFT, Kernel.ConvolutionMode.SEPARABLE):
+            output = MaskedImage(self.outputBox)
+            kernel.convolve(self.input, self.affine, output, mode=mode)
+            expected = Image(self.outputBox, dtype=np.float32)
+            kernel.convolve(self.input.image, self.affine, expected, mode=mode)
+            np.testing.assert_allclose(output.image.array, expected.array, rtol=0, atol=1E-4)
+            results.append(output)
+        # Variance and mask planes do not depend on the mode.
+        for output in results[1:]:
+            np.testing.assert_array_equal(output.variance.array, results[0].variance.array)
+            np.testing.assert_array_equal(output.mask.array, results[0].mask.array)
+        self.assertGreater((results[0].mask.array != 0).sum(), 0)
+        # Each input pixel's total weight in each output pixel is the
+        # convolution of an image that is one at just that pixel; the
+        # variance is the sum of the input variances weighted by their
+        # squares.  We check that on a small input, to keep this fast.
+        input = self.input[IndexBox(min=(-1, 4), max=(10, 14))]
+        outputBox = IndexBox(min=(0, 5), max=(8, 12))
+        impulse = Image(input.bbox, dtype=np.float32)
+        weights = Image(outputBox, dtype=np.float32)
+        variance = np.zeros(weights.array.shape, dtype=np.float64)
+        for iy in range(input.bbox.y.min, input.bbox.y.max + 1):
+            for ix in range(input.bbox.x.min, input.bbox.x.max + 1):
+                impulse.array = 0.0
+                impulse[ix, iy] = 1.0
+                kernel.convolve(impulse, self.affine, weights, mode=Kernel.ConvolutionMode.DIRECT)
+                variance += weights.array.astype(np.float64)**2*input.variance[ix, iy]
+        for mode in (Kernel.ConvolutionMode.DIRECT, Kernel.ConvolutionMode.FFT, Kernel.ConvolutionMode.SEPARABLE):
+            output = MaskedImage(outputBox)
+            kernel.convolve(input, self.affine, output, mode=mode)
+            np.testing.assert_allclose(output.variance.array, variance, rtol=1E-5)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,48 @@
+import unittest
+import numpy as np
+
+from cipells import IndexBox, IndexInterval, Image, Affine, Jacobian, Interpolant, StreamingWarp
+
+
+class StreamingWarpTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.rng = np.random.RandomState(50)
+        self.input = Image(IndexBox(min=(-7, 3), max=(120, 100)), dtype=np.float32)
+        self.input.array = self.rng.randn(*self.input.array.shape)
+        self.transform = Affine(np.array([[1.001, 0.002], [-0.003, 0.999]]), np.array([0.4, 2.2]))
+        self.outputBox = IndexBox(min=(-10, 0), max=(125, 110))
+
+    def testMatchesWarp(self):
+        interpolant = Interpolant.lanczos(3)
+        expected = Image(self.outputBox, dtype=np.float32)
+        interpolant.warp(self.input, self.transform, expected)
+        rows = []
+        streaming = StreamingWarp(interpolant, self.input.bbox, self.transform, self.outputBox, rows.append)
+        self.assertLess(streaming.bufferHeight, 12)
+        box = self.input.bbox
+        for y in range(box.y.min, box.y.max + 1, 3):
+            chunk = IndexBox(x=box.x, y=IndexInterval(min=y, max=min(y + 2, box.y.max)))
+            streaming.push(self.input[chunk])
+            # Output rows are emitted as soon as they are complete.
+            self.assertEqual(len(rows), streaming.nextOutputRow - self.outputBox.y.min)
+        streaming.finish()
+        self.assertEqual([row.bbox.y.min for row in rows], list(self.outputBox.y))
+        np.testing.assert_array_equal(np.concatenate([row.array for row in rows]), expected.array)
+
+    def testErrors(self):
+        interpolant = Interpolant.cubic
+        flip = Affine(Jacobian(np.diag([1.0, -1.0])))
+        with self.assertRaises(ValueError):
+            StreamingWarp(interpolant, self.input.bbox, flip, self.outputBox, lambda row: None)
+        with self.assertRaises(ValueError):
+            StreamingWarp(Interpolant.sinc, self.input.bbox, self.transform, self.outputBox, lambda row: None)
+        streaming = StreamingWarp(interpolant, self.input.bbox, self.transform, self.outputBox, lambda row: None)
+        with self.assertRaises(ValueError):
+            streaming.push(self.input[IndexBox(x=self.input.bbox.x, y=IndexInterval(min=10, max=12))])
+        with self.assertRaises(RuntimeError):
+            streaming.finish()
+
+
+if __name__ == "__main__":
+    unittest.main()
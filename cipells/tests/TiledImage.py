@@ -0,0 +1,91 @@
+import os
+import tempfile
+import unittest
+import numpy as np
+
+from cipells import IndexBox, Image, Affine, Interpolant, Kernel, TiledImage, warp, convolve
+
+
+class TiledImageTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+        self.rng = np.random.RandomState(50)
+        self.image = Image(IndexBox(min=(-7, 3), max=(150, 130)), dtype=np.float32)
+        self.image.array = self.rng.randn(*self.image.array.shape)
+        self.transform = Affine(np.array([[0.95, 0.3], [-0.3, 0.95]]), np.array([0.4, 20.2]))
+        self.outputBox = IndexBox(min=(0, 0), max=(139, 114))
+
+    def tearDown(self):
+        self.dir.cleanup()
+
+    def makeInput(self, maxCachedBytes):
+        path = os.path.join(self.dir.name, "input.cipt")
+        tiled = TiledImage.create(path, self.image.bbox, tileSize=32)
+        tiled.write(self.image)
+        tiled.flush()
+        return TiledImage.open(path, maxCachedBytes=maxCachedBytes)
+
+    def makeOutput(self):
+        return TiledImage.create(os.path.join(self.dir.name, "output.cipt"), self.outputBox, tileSize=25,
+                                 maxCachedBytes=4*25*25*4)
+
+    def testReadWrite(self):
+        tiled = self.makeInput(maxCachedBytes=3*32*32*4)
+        self.assertEqual(tiled.bbox, self.image.bbox)
+        self.assertFalse(tiled.isWritable)
+        self.assertEqual(tiled.getTileBBox(self.image.bbox.max), IndexBox(min=(121, 99), max=(150, 130)))
+        box = self.image.bbox.dilatedBy(4)
+        result = tiled.read(box)
+        self.assertEqual(result.bbox, box)
+        np.testing.assert_array_equal(result[self.image.bbox].array, self.image.array)
+        self.assertEqual(result.array[0, 0], 0.0)
+        stats = tiled.stats
+        self.assertEqual(stats.misses, 20)
+        self.assertLessEqual(stats.bytesCached, 3*32*32*4)
+        with self.assertRaises(Exception):
+            tiled.write(self.image)
+
+    def testOpenInvalid(self):
+        path = os.path.join(self.dir.name, "input.cipt")
+        self.makeInput(maxCachedBytes=0)
+        with open(path, "r+b") as f:
+            # The tile size follows the magic, pixel type, and bounding box.
+            f.seek(28)
+            f.write(np.int32(0).tobytes())
+        with self.assertRaises(Exception):
+            TiledImage.open(path)
+        self.makeInput(maxCachedBytes=0)
+        os.truncate(path, os.path.getsize(path) - 1)
+        with self.assertRaises(Exception):
+            TiledImage.open(path)
+
+    def testWarp(self):
+        interpolant = Interpolant.lanczos(3)
+        expected = Image(self.outputBox, dtype=np.float32)
+        interpolant.warp(self.image, self.transform, expected)
+        output = self.makeOutput()
+        warp(interpolant, self.makeInput(maxCachedBytes=8*32*32*4), self.transform, output)
+        self.assertLessEqual(output.stats.bytesCached, 4*25*25*4)
+        np.testing.assert_array_equal(output.read(self.outputBox).array, expected.array)
+
+    def testConvolve(self):
+        image = Image(IndexBox(min=(-6, -4), max=(6, 4)), dtype=np.float32)
+        image.array = self.rng.randn(*image.array.shape)
+        kernel = Kernel(image, upsampling=2, interpolant=Interpolant.cubic)
+        transform = self.transform.inverted()
+        tiledInput = self.makeInput(maxCachedBytes=8*32*32*4)
+        for transpose in (False, True):
+            expected = Image(self.outputBox, dtype=np.float32)
+            if transpose:
+                kernel.correlate(self.image, transform, expected)
+            else:
+                kernel.convolve(self.image, transform, expected)
+            output = self.makeOutput()
+            convolve(kernel, tiledInput, transform, output, transpose=transpose)
+            np.testing.assert_allclose(output.read(self.outputBox).array, expected.array,
+                                       rtol=1E-5, atol=1E-5)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,55 @@
+import unittest
+import numpy as np
+
+from cipells import (Image, IndexBox, Affine, Translation, Interpolant, Kernel, Gaussian,
+                     setThreadCount, getThreadCount)
+
+
+class ParallelTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.original = getThreadCount()
+        rng = np.random.RandomState(5)
+        self.input = Image(IndexBox(min=(0, 0), max=(150, 210)), dtype=np.float32)
+        self.input.array = rng.randn(*self.input.array.shape)
+        kernel = Image(IndexBox(min=(-4, -4), max=(4, 4)), dtype=np.float32)
+        kernel.array = rng.randn(*kernel.array.shape)
+        self.kernel = Kernel(kernel, upsampling=2)
+        self.transforms = [
+            Affine(np.array([[1.1, 0.2], [-0.1, 0.9]]), np.array([0.4, 0.25])),
+            Translation(np.array([0.3, -1.7])),
+        ]
+
+    def tearDown(self):
+        setThreadCount(self.original)
+
+    def compute(self, threads):
+        setThreadCount(threads)
+        results = []
+        for transform in self.transforms:
+            output = Image(self.input.bbox, dtype=np.float32)
+            Interpolant.quintic.warp(self.input, transform, output)
+            results.append(output.array.copy())
+            results.append(self.kernel.convolve(self.input, transform).array.copy())
+        image = Image(self.input.bbox, dtype=np.float32)
+        Gaussian(Affine(np.diag([20.0, 20.0]), np.array([70.0, 90.0])), flux=5.0).addTo(image)
+        results.append(image.array.copy())
+        return results
+
+    def testThreadCount(self):
+        setThreadCount(3)
+        self.assertEqual(getThreadCount(), 3)
+        setThreadCount(0)
+        self.assertGreaterEqual(getThreadCount(), 1)
+        with self.assertRaises(ValueError):
+            setThreadCount(-1)
+
+    def testBitIdentical(self):
+        serial = self.compute(1)
+        for threads in (2, 5):
+            for a, b in zip(serial, self.compute(threads)):
+                np.testing.assert_array_equal(a, b)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -1,7 +1,8 @@
 import unittest
 import numpy as np
 
-from cipells import Gaussian, Identity, Affine
+from cipells import (Gaussian, GaussianMixture, Identity, Translation, Affine, Image, IndexBox, Kernel,
+                     Real2, renderGaussians, setThreadCount)
 
 
 class GaussianTestCase(unittest.TestCase):
@@ -13,6 +14,234 @@ class GaussianTestCase(unittest.TestCase):
         g = Gaussian(Identity(), flux=flux)
         np.testing.assert_allclose(g(x, y), flux*np.exp(-0.5*(x**2 + y**2))/(2.0*np.pi))
 
+    def checkAddTo(self, transform):
+        bbox = IndexBox(min=(-5, -3), max=(44, 38))
+        g = Gaussian(transform, flux=3.0)
+        nSigma = 4.0
+        image = Image(bbox, dtype=np.float32)
+        image.array[:, :] = 1.0
+        g.addTo(image, nSigma=nSigma)
+        x, y = np.meshgrid(np.arange(bbox.x.min, bbox.x.max + 1, dtype=float),
+                           np.arange(bbox.y.min, bbox.y.max + 1, dtype=float))
+        # Pixels are drawn if and only if they lie within the nSigma ellipse.
+        matrix = transform.matrix
+        dx = np.linalg.solve(matrix, np.stack([x.ravel() - transform.vector[0],
+                                               y.ravel() - transform.vector[1]]))
+        inside = ((dx**2).sum(axis=0) <= nSigma**2).reshape(x.shape)
+        expected = 1.0 + np.where(inside, g(x, y), 0.0)
+        np.testing.assert_allclose(image.array, expected, rtol=1E-5, atol=1E-7)
+        # All drawn pixels lie within the bounding box of the footprint.
+        box = g.computeBBox(nSigma)
+        self.assertTrue(np.all((x[inside] >= box.x.min) & (x[inside] <= box.x.max)))
+        self.assertTrue(np.all((y[inside] >= box.y.min) & (y[inside] <= box.y.max)))
+        # Drawing again accumulates.
+        g.addTo(image, nSigma=nSigma)
+        np.testing.assert_allclose(image.array - 1.0, 2.0*(expected - 1.0), rtol=1E-5, atol=1E-7)
+
+    def testAddToSeparable(self):
+        self.checkAddTo(Affine(np.diag([3.0, 2.0]), np.array([20.3, 15.6])))
+
+    def testAddToSheared(self):
+        self.checkAddTo(Affine(np.array([[3.0, 1.2], [-0.8, 2.0]]), np.array([20.3, 15.6])))
+
+    def testAddToClipped(self):
+        # Profiles that only partially overlap the image (or not at all).
+        self.checkAddTo(Affine(np.array([[3.0, 1.2], [-0.8, 2.0]]), np.array([-6.0, 39.5])))
+        self.checkAddTo(Affine(np.diag([3.0, 2.0]), np.array([-40.0, 15.0])))
+
+    def checkIntegrated(self, matrix):
+        bbox = IndexBox(min=(0, 0), max=(20, 20))
+        g = Gaussian(Affine(matrix, np.array([10.3, 9.8])), flux=2.0)
+        image = Image(bbox, dtype=np.float32)
+        g.addTo(image, method=Gaussian.DrawMethod.INTEGRATE)
+        # Compare to the average of the profile over a fine grid within each
+        # pixel.
+        n = 64
+        offsets = (np.arange(n) + 0.5)/n - 0.5
+        r = np.arange(21, dtype=float)
+        x = r[np.newaxis, :, np.newaxis, np.newaxis] + offsets[np.newaxis, np.newaxis, np.newaxis, :]
+        y = r[:, np.newaxis, np.newaxis, np.newaxis] + offsets[np.newaxis, np.newaxis, :, np.newaxis]
+        x, y = np.broadcast_arrays(x, y)
+        expected = g(x, y).mean(axis=(2, 3))
+        np.testing.assert_allclose(image.array, expected, rtol=0.0, atol=2E-4*expected.max())
+        self.assertAlmostEqual(image.array.sum(), 2.0, places=5)
+
+    def testIntegratedSeparable(self):
+        self.checkIntegrated(np.diag([1.5, 0.8]))
+        self.checkIntegrated(np.diag([0.4, 0.3]))
+
+    def testIntegratedSheared(self):
+        self.checkIntegrated(np.array([[1.5, 0.6], [-0.3, 0.8]]))
+        self.checkIntegrated(np.array([[0.35, 0.2], [0.1, 0.3]]))
+
+
+class GaussianMixtureTestCase(unittest.TestCase):
+
+    def setUp(self):
+        center = np.array([30.2, 25.7])
+        self.galaxy = GaussianMixture([
+            Gaussian(Affine(np.array([[2.0, 0.5], [-0.3, 1.5]]), center), flux=3.0),
+            Gaussian(Affine(np.diag([1.2, 0.9]), center), flux=1.0),
+        ])
+        self.psf = GaussianMixture([
+            Gaussian(Affine(np.array([[0.8, 0.3], [0.2, 0.7]]), np.zeros(2)), flux=0.7),
+            Gaussian(Affine(np.array([[1.6, 0.6], [0.4, 1.4]]), np.zeros(2)), flux=0.3),
+        ])
+        self.bbox = IndexBox(min=(0, 0), max=(63, 59))
+
+    def testEvaluate(self):
+        x, y = np.meshgrid(np.linspace(20.0, 40.0, 11), np.linspace(15.0, 35.0, 9))
+        expected = sum(c(x, y) for c in self.galaxy.components)
+        np.testing.assert_allclose(self.galaxy(x, y), expected)
+        self.assertAlmostEqual(self.galaxy.flux, 4.0)
+
+    def testConvolution(self):
+        convolved = self.galaxy.convolvedWith(self.psf)
+        self.assertEqual(len(convolved.components), 4)
+        self.assertAlmostEqual(convolved.flux, self.galaxy.flux*self.psf.flux)
+        for i, g in enumerate(self.galaxy.components):
+            for j, p in enumerate(self.psf.components):
+                c = convolved.components[2*i + j]
+                m1, m2, m = g.transform.matrix, p.transform.matrix, c.transform.matrix
+                np.testing.assert_allclose(m.dot(m.T), m1.dot(m1.T) + m2.dot(m2.T))
+                np.testing.assert_allclose(c.transform.vector, g.transform.vector + p.transform.vector)
+                self.assertAlmostEqual(c.flux, g.flux*p.flux)
+        # Compare to a brute-force convolution at a single point.
+        h = 0.05
+        u, v = np.meshgrid(np.arange(-15.0, 15.0, h), np.arange(-15.0, 15.0, h))
+        point = (32.0, 24.5)
+        numeric = (self.galaxy(point[0] - u, point[1] - v)*self.psf(u, v)).sum()*h*h
+        self.assertAlmostEqual(convolved(*point), numeric, places=6)
+        single = self.galaxy.convolvedWith(self.psf.components[0])
+        self.assertEqual(len(single.components), 2)
+
+    def testAddTo(self):
+        convolved = self.galaxy.convolvedWith(self.psf)
+        for method in (Gaussian.DrawMethod.SAMPLE, Gaussian.DrawMethod.INTEGRATE):
+            image = Image(self.bbox, dtype=np.float32)
+            convolved.addTo(image, method=method)
+            expected = Image(self.bbox, dtype=np.float32)
+            for c in convolved.components:
+                c.addTo(expected, method=method)
+            np.testing.assert_allclose(image.array, expected.array, rtol=1E-6, atol=1E-8)
+            self.assertAlmostEqual(image.array.sum(), convolved.flux, places=4)
+            rendered = Image(self.bbox, dtype=np.float32)
+            renderGaussians([convolved, convolved.transformedBy(Affine(np.identity(2), np.array([5.0, -3.0])))],
+                            rendered, method=method, tileSize=16)
+            convolved.transformedBy(Affine(np.identity(2), np.array([5.0, -3.0]))).addTo(image, method=method)
+            np.testing.assert_allclose(rendered.array, image.array, rtol=1E-6, atol=1E-8)
+
+
+class KSpaceTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.gaussian = Gaussian(Affine(np.array([[2.0, 0.6], [-0.4, 1.5]]), np.array([30.3, 28.6])), flux=2.5)
+        self.mixture = GaussianMixture([
+            self.gaussian,
+            Gaussian(Affine(np.diag([0.8, 0.8]), np.array([26.1, 31.0])), flux=1.0),
+        ])
+
+    def testKValue(self):
+        # Compare to the discrete transform of the well-sampled profile.
+        x, y = np.meshgrid(np.arange(64, dtype=float), np.arange(64, dtype=float))
+        values = self.gaussian(x, y)
+        for kx, ky in [(0.0, 0.0), (0.4, -0.7), (-1.1, 0.3)]:
+            expected = (values*np.exp(-1j*(kx*x + ky*y))).sum()
+            self.assertAlmostEqual(self.gaussian.kValue(kx, ky), expected, places=8)
+        self.assertAlmostEqual(self.mixture.kValue(0.0, 0.0), self.mixture.flux)
+        # Transforming a profile transforms its Fourier transform, with no
+        # resampling.
+        shift = np.array([3.0, -2.5])
+        shifted = self.gaussian.transformedBy(Translation(shift))
+        k = np.array([0.3, 0.45])
+        self.assertAlmostEqual(shifted.kValue(*k), self.gaussian.kValue(*k)*np.exp(-1j*k.dot(shift)))
+
+    def testAddKTo(self):
+        bbox = IndexBox(min=(-8, -8), max=(7, 7))
+        kStep = Real2(0.1, 0.15)
+        kx, ky = bbox.meshgrid(dtype=float)
+        for profile in (self.gaussian, self.mixture):
+            image = Image(bbox, dtype=np.complex64)
+            profile.addKTo(image, kStep)
+            expected = profile.kValue(kx*kStep.x, ky*kStep.y)
+            np.testing.assert_allclose(image.array, expected, rtol=0.0, atol=1E-6)
+            integrated = Image(bbox, dtype=np.complex64)
+            profile.addKTo(integrated, kStep, method=Gaussian.DrawMethod.INTEGRATE)
+            expected *= np.sinc(0.5*kx*kStep.x/np.pi)*np.sinc(0.5*ky*kStep.y/np.pi)
+            np.testing.assert_allclose(integrated.array, expected, rtol=0.0, atol=1E-6)
+
+    def testAddConvolvedTo(self):
+        psf = Image(IndexBox(min=(-3, -3), max=(3, 3)), dtype=np.float32)
+        px, py = psf.bbox.meshgrid(dtype=float)
+        psf.array = np.exp(-0.3*(px**2 + 0.5*py**2) - 0.1*px*py)
+        psf.array[3, 4] += 0.5
+        kernel = Kernel(psf)
+        bbox = IndexBox(min=(10, 12), max=(50, 45))
+        padded = IndexBox(min=(0, 0), max=(70, 70))
+        # Elongated components need many aliases, at which the separable
+        # factors of their transforms overflow.
+        elongated = Gaussian(Affine(np.array([[2.0, 0.0], [1.0, 0.3]]), np.array([30.3, 28.6])), flux=2.5)
+        for profile in (self.gaussian, self.mixture, elongated):
+            for method in (Gaussian.DrawMethod.SAMPLE, Gaussian.DrawMethod.INTEGRATE):
+                drawn = Image(padded, dtype=np.float32)
+                profile.addTo(drawn, nSigma=8.0, method=method)
+                expected = Image(bbox, dtype=np.float32)
+                kernel.convolve(drawn, Identity(), expected, mode=Kernel.ConvolutionMode.DIRECT)
+                image = Image(bbox, dtype=np.float32)
+                profile.addConvolvedTo(kernel, image, nSigma=8.0, method=method)
+                np.testing.assert_allclose(image.array, expected.array, rtol=0.0, atol=1E-5)
+        with self.assertRaises(ValueError):
+            self.gaussian.addConvolvedTo(kernel.resample(2), Image(bbox, dtype=np.float32))
+
+
+class RenderGaussiansTestCase(unittest.TestCase):
+
+    def setUp(self):
+        rng = np.random.RandomState(5)
+        n = 500
+        self.matrices = np.zeros((n, 2, 2), dtype=float)
+        self.matrices[:, 0, 0] = rng.uniform(0.5, 3.0, size=n)
+        self.matrices[:, 1, 1] = rng.uniform(0.5, 3.0, size=n)
+        self.matrices[::2, 0, 1] = rng.uniform(-0.5, 0.5, size=n//2)
+        self.matrices[::2, 1, 0] = rng.uniform(-0.5, 0.5, size=n//2)
+        # Some sources lie partly or entirely off the image.
+        self.centers = rng.uniform(-30.0, 230.0, size=(n, 2))
+        self.fluxes = rng.uniform(1.0, 10.0, size=n)
+        self.bbox = IndexBox(min=(0, 0), max=(199, 149))
+
+    def tearDown(self):
+        setThreadCount(1)
+
+    def testMatchesAddTo(self):
+        for method in (Gaussian.DrawMethod.SAMPLE, Gaussian.DrawMethod.INTEGRATE):
+            expected = Image(self.bbox, dtype=np.float32)
+            profiles = [Gaussian(Affine(m, c), flux=f)
+                        for m, c, f in zip(self.matrices, self.centers, self.fluxes)]
+            for g in profiles:
+                g.addTo(expected, method=method)
+            fromList = Image(self.bbox, dtype=np.float32)
+            renderGaussians(profiles, fromList, method=method, tileSize=32)
+            np.testing.assert_allclose(fromList.array, expected.array, rtol=1E-6, atol=1E-7)
+            fromArrays = Image(self.bbox, dtype=np.float32)
+            renderGaussians(self.matrices, self.centers, self.fluxes, fromArrays, method=method, tileSize=32)
+            np.testing.assert_array_equal(fromArrays.array, fromList.array)
+
+    def testThreadIndependence(self):
+        results = []
+        for threads in (1, 4):
+            setThreadCount(threads)
+            image = Image(self.bbox, dtype=np.float32)
+            renderGaussians(self.matrices, self.centers, self.fluxes, image, tileSize=40)
+            results.append(image.array.copy())
+        np.testing.assert_array_equal(results[0], results[1])
+
+    def testInvalid(self):
+        image = Image(self.bbox, dtype=np.float32)
+        with self.assertRaises(ValueError):
+            renderGaussians(self.matrices, self.centers[:10], self.fluxes, image)
+        with self.assertRaises(ValueError):
+            renderGaussians(self.matrices, self.centers, self.fluxes, image, tileSize=0)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,88 @@
+import unittest
+import numpy as np
+
+from cipells import (Image, ImageLayout, IndexBox, computeStatistics, computeMoments, computeClippedStatistics,
+                     setThreadCount, getThreadCount)
+
+
+class StatisticsTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.rng = np.random.RandomState(18)
+        self.image = Image(IndexBox(min=(-30, 12), max=(270, 268)), dtype=np.float32, layout=ImageLayout.PADDED)
+        self.image.array = self.rng.normal(10.0, 2.0, size=self.image.array.shape)
+        self.image[5, 20] = 1000.0
+        self.subimage = self.image[IndexBox(min=(0, 20), max=(99, 119))]
+
+    def testStatistics(self):
+        array = self.subimage.array.astype(np.float64)
+        stats = computeStatistics(self.subimage)
+        self.assertEqual(stats.count, array.size)
+        self.assertAlmostEqual(stats.sum/array.sum(), 1.0, places=12)
+        self.assertAlmostEqual(stats.mean/array.mean(), 1.0, places=12)
+        self.assertAlmostEqual(stats.variance/array.var(), 1.0, places=12)
+        self.assertEqual(stats.min, array.min())
+        self.assertEqual(stats.max, array.max())
+
+    def testMoments(self):
+        array = self.subimage.array.astype(np.float64)
+        x, y = self.subimage.bbox.meshgrid(dtype=np.float64)
+        flux = array.sum()
+        cx = (array*x).sum()/flux
+        cy = (array*y).sum()/flux
+        moments = computeMoments(self.subimage)
+        self.assertAlmostEqual(moments.flux/flux, 1.0, places=12)
+        self.assertAlmostEqual(moments.centroid.x, cx, places=9)
+        self.assertAlmostEqual(moments.centroid.y, cy, places=9)
+        expected = np.array([
+            [(array*(x - cx)**2).sum(), (array*(x - cx)*(y - cy)).sum()],
+            [(array*(x - cx)*(y - cy)).sum(), (array*(y - cy)**2).sum()],
+        ])/flux
+        np.testing.assert_allclose(moments.secondMoments, expected, rtol=1E-9)
+
+    def testClippedStatistics(self):
+        array = self.subimage.array.astype(np.float64)
+        stats = computeClippedStatistics(self.subimage, nSigma=3.0, maxIterations=10)
+        mean, stddev = array.mean(), array.std()
+        for n in range(stats.iterations):
+            kept = array[np.abs(array - mean) <= 3.0*stddev]
+            mean, stddev = kept.mean(), kept.std()
+        self.assertEqual(stats.count, kept.size)
+        self.assertAlmostEqual(stats.mean, mean, places=10)
+        self.assertAlmostEqual(stats.stddev, stddev, places=10)
+        self.assertLess(stats.count, array.size)  # the outlier is always rejected
+
+    def testPixelTypes(self):
+        for dtype in (np.float64, np.uint16, np.int32, np.float16):
+            image = Image(self.subimage.bbox, dtype=dtype)
+            image.array = self.rng.randint(0, 1000, size=image.array.shape)
+            stats = computeStatistics(image)
+            self.assertAlmostEqual(stats.mean, image.array.astype(np.float64).mean(), places=9)
+
+    def testBatched(self):
+        stamps = [self.image[IndexBox(min=(x, y), max=(x + 15, y + 20))]
+                  for x in range(-30, 200, 37) for y in range(12, 200, 29)]
+        for single, batched in zip([computeStatistics(s) for s in stamps], computeStatistics(stamps)):
+            self.assertEqual(single.sum, batched.sum)
+            self.assertEqual(single.variance, batched.variance)
+        for single, batched in zip([computeMoments(s) for s in stamps], computeMoments(stamps)):
+            np.testing.assert_array_equal(single.secondMoments, batched.secondMoments)
+        for single, batched in zip([computeClippedStatistics(s) for s in stamps], computeClippedStatistics(stamps)):
+            self.assertEqual(single.mean, batched.mean)
+
+    def testThreadsBitIdentical(self):
+        original = getThreadCount()
+        try:
+            setThreadCount(1)
+            serial = computeStatistics(self.image)
+            for threads in (2, 5):
+                setThreadCount(threads)
+                parallel = computeStatistics(self.image)
+                self.assertEqual(serial.sum, parallel.sum)
+                self.assertEqual(serial.variance, parallel.variance)
+        finally:
+            setThreadCount(original)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -1,6 +1,8 @@
 #ifndef CIPELLS_Image_h_INCLUDED
 #define CIPELLS_Image_h_INCLUDED
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <type_traits>
 #include <complex>
@@ -8,13 +10,28 @@
 #include "Eigen/Core"
 #include "cipells/XYTuple.h"
 #include "cipells/Box.h"
+#include "cipells/parallel.h"
 #include "cipells/fwd/Image.h"
 
 namespace cipells {
 
-using ImageStorage = std::aligned_union_t<16, float, std::complex<float>>;
+// 16-bit floating point pixels, for images (such as weight maps) where
+// memory bandwidth matters more than precision.  Arithmetic on them is done
+// in float.
+using Half = Eigen::half;
+
+// Alignment (in bytes) of the storage allocated for new images.
+constexpr std::size_t IMAGE_ALIGNMENT = 64;
+
+using ImageStorage = std::aligned_storage_t<IMAGE_ALIGNMENT, IMAGE_ALIGNMENT>;
 using ImageOwner = std::shared_ptr<ImageStorage const>;
 
+// Memory layout of a newly-allocated image.  COMPACT images have no space
+// between rows; PADDED images round the stride up so every row starts on an
+// IMAGE_ALIGNMENT boundary, so row operations never split a cache line or
+// vector load at a row start.
+enum class ImageLayout { COMPACT, PADDED };
+
 
 template <typename T>
 class Image<T const> {
@@ -60,6 +77,13 @@ public:
 
     Image<T const> freeze() &&;
 
+    // Return true if every row starts on an IMAGE_ALIGNMENT boundary, as in
+    // all PADDED images and their subimages that start at the same column.
+    bool hasAlignedRows() const {
+        return reinterpret_cast<std::uintptr_t>(_data) % IMAGE_ALIGNMENT == 0 &&
+            (_stride*sizeof(T)) % IMAGE_ALIGNMENT == 0;
+    }
+
     IndexBox const & bbox() const { return _bbox; }
 
     Scalar const * data() const { return _data; }
@@ -74,7 +98,7 @@ protected:
         return _stride*(index.y() - _bbox.y0()) + (index.x() - _bbox.x0());
     }
 
-    explicit Image(IndexBox const & box);
+    Image(IndexBox const & box, ImageLayout layout);
 
 private:
     Scalar const * _data;
@@ -99,7 +123,12 @@ public:
         Base(data, bbox, std::move(owner), stride)
     {}
 
-    explicit Image(IndexBox const & box);
+    explicit Image(IndexBox const & box, ImageLayout layout=ImageLayout::COMPACT);
+
+    // Return a new image whose pixels are not initialized.
+    static Image makeUninitialized(IndexBox const & box, ImageLayout layout=ImageLayout::COMPACT) {
+        return Image(box, layout, Uninitialized());
+    }
 
     Image(Image const &) = default;
     Image(Image &&) = default;
@@ -130,9 +159,16 @@ public:
 
     Scalar * data() const { return const_cast<Scalar*>(Base::data()); }
 
+private:
+
+    struct Uninitialized {};
+
+    Image(IndexBox const & box, ImageLayout layout, Uninitialized) : Base(box, layout) {}
+
 };
 
 
+// Call func(index, pixel) for each pixel of the image.
 template <typename T, typename Func>
 void apply(Image<T> const & image, Func func) {
     T * row = image.data();
@@ -144,6 +180,37 @@ void apply(Image<T> const & image, Func func) {
     }
 }
 
+// Call func(y, x, row) for each row of the image, where x is the range of
+// columns in the row and row points to the pixel at x.min().  Pixels are
+// contiguous within a row, so loops over them in func can be vectorized.
+template <typename T, typename Func>
+void applyRows(Image<T> const & image, Func func) {
+    T * row = image.data();
+    for (Index y = image.bbox().y().min(); y <= image.bbox().y().max(); ++y, row += image.stride()) {
+        func(y, image.bbox().x(), row);
+    }
+}
+
+// As apply, but on the library's thread pool (see setThreadCount), in bands
+// of rows that do not depend on the number of threads.  Calls to func must
+// be safe to make concurrently for different pixels.
+template <typename T, typename Func>
+void parallelApply(Image<T> const & image, Func func) {
+    forEachRowBand(
+        image.bbox(),
+        [&image, &func](IndexBox const & band) { apply(image[band], func); }
+    );
+}
+
+// As applyRows, but on the library's thread pool; see parallelApply.
+template <typename T, typename Func>
+void parallelApplyRows(Image<T> const & image, Func func) {
+    forEachRowBand(
+        image.bbox(),
+        [&image, &func](IndexBox const & band) { applyRows(image[band], func); }
+    );
+}
+
 
 } // namespace cipells
 
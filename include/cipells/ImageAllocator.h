@@ -0,0 +1,55 @@
+#ifndef CIPELLS_ImageAllocator_h_INCLUDED
+#define CIPELLS_ImageAllocator_h_INCLUDED
+
+#include <cstddef>
+#include <memory>
+
+#include "cipells/Image.h"
+
+namespace cipells {
+
+// Counters describing an ImageAllocator's activity since it was created.
+struct ImageAllocationStats {
+    std::size_t allocations;    // calls to allocate()
+    std::size_t reused;         // allocations satisfied by storage cached for reuse
+    std::size_t bytesInUse;     // bytes held by live images
+    std::size_t bytesCached;    // bytes released by images and cached for reuse
+};
+
+// Source of the storage for new images.
+class ImageAllocator {
+public:
+
+    // Return an allocator that allocates and frees storage on every call.
+    static std::shared_ptr<ImageAllocator> makeHeap();
+
+    // Return an allocator that rounds each request up to one of a set of
+    // size classes (at most 25% larger), and caches released storage to
+    // satisfy later requests in the same class.  At most maxCachedBytes are
+    // cached at once; storage released beyond that is freed (or all of it,
+    // by trim).  Pools are only used when passed to setImageAllocator.
+    static std::shared_ptr<ImageAllocator> makePool(std::size_t maxCachedBytes=(std::size_t(1) << 30));
+
+    // Return storage for at least the given number of bytes, with the first
+    // byte aligned to IMAGE_ALIGNMENT.  The storage is not initialized.
+    virtual ImageOwner allocate(std::size_t bytes) = 0;
+
+    virtual ImageAllocationStats stats() const = 0;
+
+    // Free any storage cached for reuse.
+    virtual void trim() {}
+
+    virtual ~ImageAllocator() {}
+
+};
+
+// Set the allocator used for the storage of all new images.  The default
+// (restored by passing nullptr) is the heap allocator, which caches nothing;
+// programs that create and destroy many large images can opt in to a pool.
+void setImageAllocator(std::shared_ptr<ImageAllocator> allocator);
+
+std::shared_ptr<ImageAllocator> getImageAllocator();
+
+} // namespace cipells
+
+#endif // !CIPELLS_ImageAllocator_h_INCLUDED
@@ -0,0 +1,278 @@
+#ifndef CIPELLS_ImageExpression_h_INCLUDED
+#define CIPELLS_ImageExpression_h_INCLUDED
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "cipells/Image.h"
+#include "cipells/parallel.h"
+
+namespace cipells {
+
+// Lazy elementwise arithmetic on images.
+//
+// Arithmetic operators on Images (and on the expressions they return) do no
+// work; they build an expression that is only computed by evaluate() or
+// assign(), in a single pass that reads each input pixel once and writes
+// each output pixel once, with no temporary images.  Each node of an
+// expression yields an Eigen array expression for any subimage of its
+// bounding box, so Eigen fuses the whole chain into one loop per row band.
+//
+// The bounding box of an expression with two image operands is the
+// intersection of theirs.  Scalars are converted to the pixel type of the
+// image operand, except that integer pixels combined with a floating-point
+// scalar are promoted to the type of their product (as in NumPy), so a uint16
+// image times 2.5 is a double expression rather than the image times 2.
+// Image operands with different pixel types must be matched explicitly with
+// cast<U>().
+//
+// For example, a calibration chain on a raw uint16 frame:
+//
+//     Image<float> calibrated = evaluate((cast<float>(raw) - bias)*gain/flat);
+//
+// Expressions hold their images by value, so they remain valid even if the
+// images they were built from are reassigned.  An image may appear in an
+// expression assigned to itself, as long as it is not also used through a
+// shifted view.
+class ImageExpressionBase {};
+
+template <typename Derived>
+class ImageExpression : public ImageExpressionBase {
+public:
+
+    Derived const & derived() const { return static_cast<Derived const &>(*this); }
+
+};
+
+
+// Expression node for an image.
+template <typename T>
+class ImageLeafExpression : public ImageExpression<ImageLeafExpression<T>> {
+public:
+
+    explicit ImageLeafExpression(Image<T const> image) : _image(std::move(image)) {}
+
+    IndexBox const & bbox() const { return _image.bbox(); }
+
+    auto array(IndexBox const & box) const { return _image.array(box); }
+
+private:
+    Image<T const> _image;
+};
+
+
+// Expression node for a function of one expression's Eigen arrays.
+template <typename Func, typename Operand>
+class ImageUnaryExpression : public ImageExpression<ImageUnaryExpression<Func, Operand>> {
+public:
+
+    ImageUnaryExpression(Func func, Operand operand) : _func(std::move(func)), _operand(std::move(operand)) {}
+
+    IndexBox const & bbox() const { return _operand.bbox(); }
+
+    auto array(IndexBox const & box) const { return _func(_operand.array(box)); }
+
+private:
+    Func _func;
+    Operand _operand;
+};
+
+
+// Expression node for a function of two expressions' Eigen arrays.
+template <typename Func, typename Lhs, typename Rhs>
+class ImageBinaryExpression : public ImageExpression<ImageBinaryExpression<Func, Lhs, Rhs>> {
+public:
+
+    ImageBinaryExpression(Func func, Lhs lhs, Rhs rhs) :
+        _func(std::move(func)), _lhs(std::move(lhs)), _rhs(std::move(rhs)),
+        _bbox(_lhs.bbox().clippedTo(_rhs.bbox()))
+    {}
+
+    IndexBox const & bbox() const { return _bbox; }
+
+    auto array(IndexBox const & box) const { return _func(_lhs.array(box), _rhs.array(box)); }
+
+private:
+    Func _func;
+    Lhs _lhs;
+    Rhs _rhs;
+    IndexBox _bbox;
+};
+
+
+namespace detail {
+
+// Map an Image or expression type to the expression node that represents
+// it; there is no Type member for anything else, which removes the
+// operators below from overload resolution.
+template <typename X, typename Enable=void>
+struct AsImageExpression {};
+
+template <typename T>
+struct AsImageExpression<Image<T>> {
+    using Type = ImageLeafExpression<std::remove_const_t<T>>;
+    static Type apply(Image<T> const & image) { return Type(image); }
+};
+
+template <typename X>
+struct AsImageExpression<X, std::enable_if_t<std::is_base_of<ImageExpressionBase, X>::value>> {
+    using Type = X;
+    static X const & apply(X const & expression) { return expression; }
+};
+
+template <typename X>
+using ImageExpressionOf = typename AsImageExpression<X>::Type;
+
+template <typename X>
+ImageExpressionOf<X> asImageExpression(X const & operand) {
+    return AsImageExpression<X>::apply(operand);
+}
+
+// Pixel type of an expression.
+template <typename X>
+using ImageExpressionScalar = typename std::decay_t<
+    decltype(std::declval<ImageExpressionOf<X> const &>().array(std::declval<IndexBox const &>()))
+>::Scalar;
+
+// Type in which pixels of type T are combined with a scalar of type S (see
+// ImageExpression).
+template <typename T, typename S>
+using ScalarOpType = std::conditional_t<
+    std::is_integral<T>::value && !std::is_integral<S>::value,
+    decltype(T()*std::conditional_t<std::is_same<S, Half>::value, float, S>()),
+    T
+>;
+
+// Combine an array (cast to the scalar's type, if they differ) with a
+// scalar, on either side.
+template <typename Op, typename S, bool scalarOnLeft>
+struct ScalarOp {
+    S scalar;
+
+    template <typename A>
+    auto operator()(A const & a) const {
+        return call(a.template cast<S>(), std::integral_constant<bool, scalarOnLeft>());
+    }
+
+private:
+
+    template <typename A>
+    auto call(A const & a, std::false_type) const { return Op()(a, scalar); }
+
+    template <typename A>
+    auto call(A const & a, std::true_type) const { return Op()(scalar, a); }
+};
+
+struct NegateOp {
+    template <typename A>
+    auto operator()(A const & a) const { return -a; }
+};
+
+template <typename U>
+struct CastOp {
+    template <typename A>
+    auto operator()(A const & a) const { return a.template cast<U>(); }
+};
+
+template <typename Func>
+struct MapOp {
+    Func func;
+
+    template <typename A>
+    auto operator()(A const & a) const { return a.unaryExpr(func); }
+};
+
+template <typename Op, typename L, typename R>
+ImageBinaryExpression<Op, ImageExpressionOf<L>, ImageExpressionOf<R>> makeBinary(L const & lhs, R const & rhs) {
+    return ImageBinaryExpression<Op, ImageExpressionOf<L>, ImageExpressionOf<R>>(
+        Op(), asImageExpression(lhs), asImageExpression(rhs)
+    );
+}
+
+template <typename Op, bool scalarOnLeft, typename X, typename S>
+ImageUnaryExpression<ScalarOp<Op, ScalarOpType<ImageExpressionScalar<X>, S>, scalarOnLeft>, ImageExpressionOf<X>>
+makeScalar(X const & operand, S scalar) {
+    using U = ScalarOpType<ImageExpressionScalar<X>, S>;
+    using Func = ScalarOp<Op, U, scalarOnLeft>;
+    return ImageUnaryExpression<Func, ImageExpressionOf<X>>(
+        Func{static_cast<U>(scalar)}, asImageExpression(operand)
+    );
+}
+
+template <typename S>
+using EnableIfScalar = std::enable_if_t<std::is_arithmetic<S>::value || std::is_same<S, Half>::value>;
+
+} // namespace detail
+
+
+#define CIPELLS_IMAGE_EXPRESSION_OPERATOR(OP, FUNC) \
+    template <typename L, typename R> \
+    auto OP(L const & lhs, R const & rhs) -> decltype(detail::makeBinary<FUNC>(lhs, rhs)) { \
+        return detail::makeBinary<FUNC>(lhs, rhs); \
+    } \
+    template <typename X, typename S, typename = detail::EnableIfScalar<S>> \
+    auto OP(X const & operand, S scalar) -> decltype(detail::makeScalar<FUNC, false>(operand, scalar)) { \
+        return detail::makeScalar<FUNC, false>(operand, scalar); \
+    } \
+    template <typename S, typename X, typename = detail::EnableIfScalar<S>> \
+    auto OP(S scalar, X const & operand) -> decltype(detail::makeScalar<FUNC, true>(operand, scalar)) { \
+        return detail::makeScalar<FUNC, true>(operand, scalar); \
+    }
+
+CIPELLS_IMAGE_EXPRESSION_OPERATOR(operator+, std::plus<>)
+CIPELLS_IMAGE_EXPRESSION_OPERATOR(operator-, std::minus<>)
+CIPELLS_IMAGE_EXPRESSION_OPERATOR(operator*, std::multiplies<>)
+CIPELLS_IMAGE_EXPRESSION_OPERATOR(operator/, std::divides<>)
+
+#undef CIPELLS_IMAGE_EXPRESSION_OPERATOR
+
+template <typename X>
+auto operator-(X const & operand)
+    -> ImageUnaryExpression<detail::NegateOp, detail::ImageExpressionOf<X>>
+{
+    return {detail::NegateOp(), detail::asImageExpression(operand)};
+}
+
+// Convert the pixels of an image or expression to another type.
+template <typename U, typename X>
+auto cast(X const & operand) -> ImageUnaryExpression<detail::CastOp<U>, detail::ImageExpressionOf<X>> {
+    return {detail::CastOp<U>(), detail::asImageExpression(operand)};
+}
+
+// Apply an arbitrary function to each pixel of an image or expression.
+template <typename X, typename Func>
+auto mapPixels(X const & operand, Func func)
+    -> ImageUnaryExpression<detail::MapOp<Func>, detail::ImageExpressionOf<X>>
+{
+    return {detail::MapOp<Func>{std::move(func)}, detail::asImageExpression(operand)};
+}
+
+// Compute an expression into the pixels of the output image that are within
+// its bounding box, leaving any others unchanged.
+template <typename T, typename X>
+auto assign(Image<T> const & output, X const & operand) -> decltype(detail::asImageExpression(operand), void()) {
+    auto const & expression = detail::asImageExpression(operand);
+    IndexBox box = output.bbox().clippedTo(expression.bbox());
+    forEachRowBand(
+        box,
+        [&output, &expression](IndexBox const & band) { output.array(band) = expression.array(band); }
+    );
+}
+
+// Compute an expression into a new image covering its bounding box.
+template <typename X>
+auto evaluate(X const & operand, ImageLayout layout=ImageLayout::COMPACT)
+    -> Image<detail::ImageExpressionScalar<X>>
+{
+    auto result = Image<detail::ImageExpressionScalar<X>>::makeUninitialized(
+        detail::asImageExpression(operand).bbox(),
+        layout
+    );
+    assign(result, operand);
+    return result;
+}
+
+} // namespace cipells
+
+#endif // !CIPELLS_ImageExpression_h_INCLUDED
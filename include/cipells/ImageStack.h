@@ -0,0 +1,106 @@
+#ifndef CIPELLS_ImageStack_h_INCLUDED
+#define CIPELLS_ImageStack_h_INCLUDED
+
+#include "cipells/Image.h"
+
+namespace cipells {
+
+// Memory layout of an ImageStack.  PLANAR stacks store each plane as an
+// ordinary (padded) image, one after the other; INTERLEAVED stacks store all
+// of the planes' values for each pixel together.
+enum class StackLayout { PLANAR, INTERLEAVED };
+
+// A stack of images (e.g. bands or epochs) that share a bounding box, which
+// can be warped or convolved together with the interpolation weights for
+// each output pixel computed only once.
+//
+// Like Image, an ImageStack is a view: copies and subimages share pixels.
+template <typename T>
+class ImageStack {
+public:
+
+    using Scalar = T;
+
+    // Eigen view of the pixels of one plane.
+    using Array = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+                             Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+    ImageStack();
+
+    // Allocate a new stack with the given number of planes, with all pixels
+    // zero.
+    ImageStack(IndexBox const & bbox, Index planeCount, StackLayout layout=StackLayout::PLANAR);
+
+    ImageStack(ImageStack const &);
+    ImageStack(ImageStack &&);
+
+    ImageStack & operator=(ImageStack const &);
+    ImageStack & operator=(ImageStack &&);
+
+    ~ImageStack();
+
+    // Return a view of all planes within a subimage.
+    ImageStack operator[](IndexBox const & box) const;
+
+    // Return a view of one plane of a PLANAR stack; throws std::logic_error
+    // for INTERLEAVED stacks (use array or copyPlane instead).
+    Image<T> operator[](Index plane) const;
+
+    T & operator()(Index2 const & index, Index plane) const {
+        assert(bbox().contains(index) && plane >= 0 && plane < planeCount());
+        return _data[_offset(index) + plane*_planeStride];
+    }
+
+    Array array(Index plane) const { return array(plane, bbox()); }
+
+    Array array(Index plane, IndexBox const & box) const {
+        assert(bbox().contains(box) && plane >= 0 && plane < planeCount());
+        return Array(_data + _offset(box.min()) + plane*_planeStride, box.height(), box.width(),
+                     Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(_rowStride, _pixelStride));
+    }
+
+    // Return a new image holding a copy of one plane.
+    Image<T> copyPlane(Index plane) const;
+
+    // Copy the pixels of the given image that overlap the stack's bounding
+    // box into one plane.
+    void setPlane(Index plane, Image<T const> const & image) const;
+
+    IndexBox const & bbox() const { return _bbox; }
+
+    Index planeCount() const { return _planeCount; }
+
+    StackLayout layout() const { return _layout; }
+
+    T * data() const { return _data; }
+
+    // Distances (in elements) between adjacent rows, adjacent pixels in a
+    // row, and adjacent planes at the same pixel.
+    Index rowStride() const { return _rowStride; }
+    Index pixelStride() const { return _pixelStride; }
+    Index planeStride() const { return _planeStride; }
+
+    ImageOwner const & owner() const { return _owner; }
+
+private:
+
+    ImageStack(T * data, IndexBox const & bbox, Index planeCount, StackLayout layout,
+               Index rowStride, Index planeStride, ImageOwner owner);
+
+    Index _offset(Index2 const & index) const {
+        return _rowStride*(index.y() - _bbox.y0()) + _pixelStride*(index.x() - _bbox.x0());
+    }
+
+    T * _data;
+    IndexBox _bbox;
+    Index _planeCount;
+    StackLayout _layout;
+    Index _rowStride;
+    Index _pixelStride;
+    Index _planeStride;
+    ImageOwner _owner;
+};
+
+} // namespace cipells
+
+#endif // !CIPELLS_ImageStack_h_INCLUDED
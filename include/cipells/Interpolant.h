@@ -2,6 +2,8 @@
 #define CIPELLS_Interpolant_h_INCLUDED
 
 #include "cipells/Image.h"
+#include "cipells/ImageStack.h"
+#include "cipells/MaskedImage.h"
 #include "cipells/transforms.h"
 
 namespace cipells {
@@ -11,14 +13,52 @@ public:
 
     static std::shared_ptr<Interpolant const> default_();
 
+    // Warps with the sinc interpolant by a translation combined with integer
+    // up- or downsampling (a diagonal Jacobian whose entries, or their
+    // reciprocals, are integers to within 1E-10) are computed exactly in
+    // Fourier space, treating the input as periodic: flux shifted off one
+    // edge reappears at the opposite edge.  Other transforms sum over the
+    // full input image, treating pixels beyond it as zero.  Pixels near the
+    // edges can therefore change discontinuously when a transform is
+    // perturbed away from (or rounded onto) one of the special cases.
     static std::shared_ptr<Interpolant const> sinc();
 
     static std::shared_ptr<Interpolant const> cubic();
 
     static std::shared_ptr<Interpolant const> quintic();
 
+    static std::shared_ptr<Interpolant const> lanczos(Index order);
+
+    // Return an interpolant that looks up the weights of the given one in a
+    // table computed at the given number of fractional phases per pixel,
+    // either rounding to the nearest phase or linearly blending between
+    // adjacent phases.  The accuracy lost is reported by maxError().
+    static std::shared_ptr<Interpolant const> tabulate(
+        std::shared_ptr<Interpolant const> exact,
+        Index phases=1024,
+        bool blend=false
+    );
+
+    virtual Real radius() const = 0;
+
+    // Maximum absolute difference between this interpolant and the exact
+    // one it approximates (zero for interpolants that are not tabulated).
+    virtual double maxError() const { return 0.0; }
+
     virtual double operator()(double x) const = 0;
 
+    // Evaluate the interpolant at each element of x, using vectorized
+    // instructions when the interpolant supports them.
+    virtual void evaluate(
+        Eigen::Ref<Eigen::ArrayXf const> const & x,
+        Eigen::Ref<Eigen::ArrayXf> output
+    ) const = 0;
+
+    // Convolve (or correlate, if transpose is true) the input image with a
+    // kernel sampled on a grid upsampled by the given factor and interpolated
+    // with this interpolant, evaluating the result at the positions of the
+    // output pixels.  The transform maps input coordinates to output
+    // coordinates.
     virtual void convolve(
         Image<float const> const & input,
         Image<float const> const & kernel,
@@ -28,12 +68,120 @@ public:
         bool transpose
     ) const = 0;
 
+    // Convolve integer or half-precision input, converting each pixel to
+    // float as it is read.
+    virtual void convolve(
+        Image<std::uint16_t const> const & input,
+        Image<float const> const & kernel,
+        Index upsampling,
+        Affine const & transform,
+        Image<float> const & output,
+        bool transpose
+    ) const = 0;
+
+    virtual void convolve(
+        Image<Half const> const & input,
+        Image<float const> const & kernel,
+        Index upsampling,
+        Affine const & transform,
+        Image<float> const & output,
+        bool transpose
+    ) const = 0;
+
+    // Convolve each plane of a stack, sharing the interpolation weights
+    // between planes as in the stack overload of warp.
+    virtual void convolve(
+        ImageStack<float> const & input,
+        Image<float const> const & kernel,
+        Index upsampling,
+        Affine const & transform,
+        ImageStack<float> const & output,
+        bool transpose
+    ) const = 0;
+
+    // Evaluate the interpolated input at transform(x) for the position x of
+    // each output pixel.  Input pixels beyond the bounding box are treated
+    // as zero, except by the sinc interpolant's Fourier-space special cases,
+    // which treat the input as periodic (see sinc()).
+    virtual void warp(
+        Image<float const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const = 0;
+
+    // Warp each plane of a stack with the same transform, computing the
+    // weights for each output pixel once for all planes.  The stacks must
+    // have the same number of planes, but may have different layouts.
+    virtual void warp(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output
+    ) const = 0;
+
+    // Warp the image, mask and variance planes together, computing the
+    // weights for each output pixel once (see MaskedImage).
     virtual void warp(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const = 0;
+
+    // Warp integer or half-precision input, converting each pixel to float
+    // as it is read.
+    virtual void warp(
+        Image<std::uint16_t const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const = 0;
+
+    virtual void warp(
+        Image<Half const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const = 0;
+
+    // As warp, but always summing over each output pixel's footprint in the
+    // input (treating pixels beyond the bounding box as zero), even when a
+    // Fourier-space special case applies.  Convolution with a Kernel uses
+    // these, so every convolution mode sees the same boundary conditions.
+    virtual void warpDirect(
         Image<float const> const & input,
         Affine const & transform,
         Image<float> const & output
     ) const = 0;
 
+    virtual void warpDirect(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output
+    ) const = 0;
+
+    virtual void warpDirect(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const = 0;
+
+    // Warp the image and mask planes of a masked convolution's upsampled
+    // intermediate (the input convolved with the kernel on the upsampled
+    // grid, as convolve computes it) as warpDirect does, and compute each
+    // output variance from the input's, computing the interpolation weights
+    // for each output pixel once for all three.  The variance is the sum
+    // over input pixels of each one's variance times the square of its total
+    // weight in the output pixel, through both the kernel and this
+    // interpolant.  The weights are the kernel as applied on the upsampled
+    // grid (scaled by upsampling^2, and reversed when correlating), and the
+    // transform maps output coordinates to upsampled ones.
+    virtual void warpConvolved(
+        Image<float const> const & image,
+        Image<MaskPixel const> const & mask,
+        Image<float const> const & variance,
+        Image<float const> const & weights,
+        Index upsampling,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const = 0;
+
     virtual ~Interpolant() {}
 
 };
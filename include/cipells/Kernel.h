@@ -2,6 +2,8 @@
 #define CIPELLS_Kernel_h_INCLUDED
 
 #include "cipells/Image.h"
+#include "cipells/ImageStack.h"
+#include "cipells/MaskedImage.h"
 #include "cipells/transforms.h"
 #include "cipells/Interpolant.h"
 #include "cipells/Kernel.h"
@@ -11,6 +13,15 @@ namespace cipells {
 class Kernel {
 public:
 
+    // Algorithm used to convolve or correlate with the kernel.  FFT mode
+    // computes the convolution on the kernel's upsampled grid with
+    // overlap-save blocks, transforming the kernel only once per Kernel (and
+    // its copies); SEPARABLE (only for kernels returned by decompose) runs a
+    // pair of 1-D passes for each separable term; DIRECT sums over the
+    // kernel pixels.  AUTO picks whichever is expected to be fastest for the
+    // kernel's size, rank and upsampling.
+    enum class ConvolutionMode { AUTO, DIRECT, FFT, SEPARABLE };
+
     explicit Kernel(Image<float const> && image, Index upsampling=1,
                     std::shared_ptr<Interpolant const> interpolant=nullptr);
 
@@ -28,26 +39,151 @@ public:
     Kernel warp(Affine const & transform, IndexBox const & bbox, Index upsampling=1,
                 std::shared_ptr<Interpolant const> interpolant=nullptr) const;
 
+    // Return a kernel whose image is the sum of the fewest separable terms
+    // (outer products of a column and a row, from the SVD of this kernel's
+    // image) whose RMS residual, relative to the RMS of this kernel's image,
+    // is at most the given tolerance.
+    Kernel decompose(Real tolerance) const;
+
+    // Number of separable terms in a kernel returned by decompose (zero for
+    // other kernels).
+    Index separableRank() const;
+
+    // Relative RMS difference between this kernel's image and the one it
+    // was decomposed from (zero for kernels not returned by decompose).
+    Real separableResidual() const;
+
     void convolve(
         Image<float const> const & input,
         Affine const & transform,
-        Image<float> const & output
+        Image<float> const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
     ) const;
 
-    Image<float> convolve(Image<float const> const & input, Affine const & transform) const;
+    Image<float> convolve(Image<float const> const & input, Affine const & transform,
+                          ConvolutionMode mode=ConvolutionMode::AUTO) const;
+
+    // Convolve integer or half-precision input, converting each pixel to
+    // float as it is read.
+    void convolve(
+        Image<std::uint16_t const> const & input,
+        Affine const & transform,
+        Image<float> const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
+    ) const;
+
+    void convolve(
+        Image<Half const> const & input,
+        Affine const & transform,
+        Image<float> const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
+    ) const;
 
     void correlate(
         Image<float const> const & input,
         Affine const & transform,
-        Image<float> const & output
+        Image<float> const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
+    ) const;
+
+    Image<float> correlate(Image<float const> const & input, Affine const & transform,
+                           ConvolutionMode mode=ConvolutionMode::AUTO) const;
+
+    void correlate(
+        Image<std::uint16_t const> const & input,
+        Affine const & transform,
+        Image<float> const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
+    ) const;
+
+    void correlate(
+        Image<Half const> const & input,
+        Affine const & transform,
+        Image<float> const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
+    ) const;
+
+    // Convolve (or correlate) each plane of a stack, computing the
+    // interpolation weights for each output pixel once for all planes.
+    void convolve(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
     ) const;
 
-    Image<float> correlate(Image<float const> const & input, Affine const & transform) const;
+    void correlate(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
+    ) const;
+
+    // Convolve (or correlate) the image, mask and variance planes together
+    // (see MaskedImage).  The mode applies to the image plane.  Each output
+    // variance is the sum of the input variances weighted by the square of
+    // each input pixel's total weight through both the kernel and the
+    // interpolant (see Interpolant::warpConvolved), and each output mask
+    // is the OR of the masks of the input pixels that reach it through
+    // nonzero kernel values and interpolation weights.
+    void convolve(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
+    ) const;
+
+    void correlate(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output,
+        ConvolutionMode mode=ConvolutionMode::AUTO
+    ) const;
+
+    // Return the mode AUTO resolves to for this kernel.
+    ConvolutionMode chooseConvolutionMode() const;
 
 private:
+
+    struct Spectra;
+    struct Decomposition;
+
+    template <typename T>
+    void _convolve(
+        Image<T const> const & input,
+        Affine const & transform,
+        Image<float> const & output,
+        ConvolutionMode mode,
+        bool transpose
+    ) const;
+
+    void _convolveStack(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output,
+        ConvolutionMode mode,
+        bool transpose
+    ) const;
+
+    void _convolveMasked(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output,
+        ConvolutionMode mode,
+        bool transpose
+    ) const;
+
+    template <typename T>
+    void _stuffFFT(Image<T const> const & input, Image<float> const & stuffed, bool transpose) const;
+
+    template <typename T>
+    void _stuffSeparable(Image<T const> const & input, Image<float> const & stuffed, bool transpose) const;
+
     Image<float const> _image;
     Index _upsampling;
     std::shared_ptr<Interpolant const> _interpolant;
+    std::shared_ptr<Spectra> _spectra;
+    std::shared_ptr<Decomposition const> _decomposition;
 };
 
 
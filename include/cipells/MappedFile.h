@@ -0,0 +1,92 @@
+#ifndef CIPELLS_MappedFile_h_INCLUDED
+#define CIPELLS_MappedFile_h_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "cipells/Image.h"
+
+namespace cipells {
+
+// A file mapped into memory, from which images can be viewed without
+// copying.  Pages are read from disk only when pixels on them are first
+// accessed, and writes to pixels of writable mappings go back to the file.
+// Copies share the same mapping, which is unmapped when the last copy and
+// the last image viewing it have been destroyed.
+class MappedFile {
+public:
+
+    static MappedFile open(std::string const & path, bool writable=false);
+
+    // Create (or truncate) a file of the given size, filled with zeros, and
+    // map it for writing.
+    static MappedFile create(std::string const & path, std::size_t size);
+
+    std::size_t size() const;
+
+    bool isWritable() const;
+
+    // Return the first of the mapped bytes.
+    char const * data() const;
+
+    // Return the mapped bytes, throwing if the file is not mapped for writing.
+    char * writableData() const;
+
+    // Return a view of a raw, row-major array of pixels that starts the
+    // given number of bytes into the file, with the given number of pixels
+    // between row starts (zero for the width of the box).
+    template <typename T>
+    Image<T const> view(IndexBox const & bbox, std::size_t offset=0, Index stride=0) const;
+
+    template <typename T>
+    Image<T> writableView(IndexBox const & bbox, std::size_t offset=0, Index stride=0) const;
+
+private:
+
+    struct Mapping;
+
+    explicit MappedFile(std::shared_ptr<Mapping> mapping) : _mapping(std::move(mapping)) {}
+
+    template <typename T>
+    T * _view(IndexBox const & bbox, std::size_t offset, Index & stride) const;
+
+    std::shared_ptr<Mapping> _mapping;
+};
+
+
+// Pixel types that can be stored in image files.
+enum class PixelType { FLOAT32 = 1, COMPLEX64 = 2, FLOAT64 = 3, UINT16 = 4, INT32 = 5, FLOAT16 = 6 };
+
+// Cipells image files start with an IMAGE_FILE_HEADER_SIZE-byte header
+// (the string "CIPELLS1", then 32-bit integers for the pixel type, x0, y0,
+// width, height and stride), followed by the rows of pixels.
+constexpr std::size_t IMAGE_FILE_HEADER_SIZE = 64;
+
+// Create an image file with the given bounding box, with all pixels zero,
+// and return a writable view of its pixels.
+template <typename T>
+Image<T> createImageFile(std::string const & path, IndexBox const & bbox,
+                         ImageLayout layout=ImageLayout::COMPACT);
+
+template <typename T>
+Image<T const> openImageFile(std::string const & path);
+
+template <typename T>
+Image<T> openWritableImageFile(std::string const & path);
+
+PixelType readImageFilePixelType(std::string const & path);
+
+
+// Access-pattern hints for the memory backing an image (see madvise(2)).
+// They are most useful for images viewing a MappedFile, where SEQUENTIAL
+// enables aggressive read-ahead for row-by-row scans and WILLNEED starts
+// reading pages before they are accessed.
+enum class MapAdvice { NORMAL, SEQUENTIAL, RANDOM, WILLNEED };
+
+template <typename T>
+void advise(Image<T const> const & image, MapAdvice advice);
+
+} // namespace cipells
+
+#endif // !CIPELLS_MappedFile_h_INCLUDED
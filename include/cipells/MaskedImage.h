@@ -0,0 +1,58 @@
+#ifndef CIPELLS_MaskedImage_h_INCLUDED
+#define CIPELLS_MaskedImage_h_INCLUDED
+
+#include <cstdint>
+
+#include "cipells/Image.h"
+
+namespace cipells {
+
+// Pixel type of mask planes, in which each bit flags a different condition
+// (e.g. saturated or cosmic-ray pixels).
+using MaskPixel = std::int32_t;
+
+// An image together with a bitmask plane and a variance plane with the same
+// bounding box.
+//
+// Warping or convolving a MaskedImage computes the weights for each output
+// pixel once and uses them for all three planes: output pixels are the
+// weighted sum of input pixels, output variances the sum of the input
+// variances weighted by the squared weights (ignoring any covariance), and
+// output masks the bitwise OR of the masks of all input pixels with nonzero
+// weight.
+//
+// Like Image, a MaskedImage is a view: copies and subimages share pixels.
+class MaskedImage {
+public:
+
+    MaskedImage() = default;
+
+    // Allocate new planes, with all pixels zero.
+    explicit MaskedImage(IndexBox const & bbox, ImageLayout layout=ImageLayout::COMPACT);
+
+    // View existing planes, which must have the same bounding box.
+    MaskedImage(Image<float> image, Image<MaskPixel> mask, Image<float> variance);
+
+    MaskedImage operator[](IndexBox const & box) const {
+        return MaskedImage(_image[box], _mask[box], _variance[box]);
+    }
+
+    MaskedImage copy() const;
+
+    IndexBox const & bbox() const { return _image.bbox(); }
+
+    Image<float> const & image() const { return _image; }
+
+    Image<MaskPixel> const & mask() const { return _mask; }
+
+    Image<float> const & variance() const { return _variance; }
+
+private:
+    Image<float> _image;
+    Image<MaskPixel> _mask;
+    Image<float> _variance;
+};
+
+} // namespace cipells
+
+#endif // !CIPELLS_MaskedImage_h_INCLUDED
@@ -0,0 +1,73 @@
+#ifndef CIPELLS_StreamingWarp_h_INCLUDED
+#define CIPELLS_StreamingWarp_h_INCLUDED
+
+#include <functional>
+#include <memory>
+
+#include "cipells/Image.h"
+#include "cipells/transforms.h"
+#include "cipells/Interpolant.h"
+
+namespace cipells {
+
+// A warp that consumes its input one row at a time (in increasing y) and
+// emits each output row as soon as all of the input rows within the
+// interpolant's radius of it have been pushed.  Only a ring buffer of the
+// input rows the current output row needs is kept in memory, so images
+// much larger than memory can be warped directly from a reader, as long as
+// output rows only need input rows at or after those of earlier output rows
+// (i.e. the transform does not flip the y axis).
+//
+// Output rows are identical to those Interpolant::warp computes from the
+// full input image.
+class StreamingWarp {
+public:
+
+    // Function called with each output row, in increasing y.  The row's
+    // pixels are only valid until the function returns.
+    using Sink = std::function<void(Image<float const> const &)>;
+
+    // The transform maps output coordinates to input coordinates, as in
+    // Interpolant::warp.
+    StreamingWarp(
+        std::shared_ptr<Interpolant const> interpolant,
+        IndexBox const & inputBBox,
+        Affine const & transform,
+        IndexBox const & outputBBox,
+        Sink sink
+    );
+
+    StreamingWarp(StreamingWarp const &) = delete;
+    StreamingWarp(StreamingWarp &&);
+
+    StreamingWarp & operator=(StreamingWarp const &) = delete;
+    StreamingWarp & operator=(StreamingWarp &&);
+
+    ~StreamingWarp();
+
+    // Push one or more input rows, which must span the input bounding box
+    // in x and start at nextInputRow().  Output rows that become complete
+    // are passed to the sink before this returns.
+    void push(Image<float const> const & rows);
+
+    // Emit any remaining output rows, which requires that all input rows
+    // have been pushed.
+    void finish();
+
+    // Number of input rows held in memory at once.
+    Index bufferHeight() const;
+
+    Index nextInputRow() const;
+
+    Index nextOutputRow() const;
+
+private:
+
+    class Impl;
+
+    std::unique_ptr<Impl> _impl;
+};
+
+} // namespace cipells
+
+#endif // !CIPELLS_StreamingWarp_h_INCLUDED
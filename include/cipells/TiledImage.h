@@ -0,0 +1,102 @@
+#ifndef CIPELLS_TiledImage_h_INCLUDED
+#define CIPELLS_TiledImage_h_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "cipells/Image.h"
+#include "cipells/transforms.h"
+
+namespace cipells {
+
+class Interpolant;
+class Kernel;
+
+// Counters describing a TiledImage's tile cache since it was opened.
+struct TileCacheStats {
+    std::size_t hits;           // tile requests satisfied by the cache
+    std::size_t misses;         // tile requests that had to read (or create) a tile
+    std::size_t writes;         // modified tiles written back to the file
+    std::size_t bytesCached;    // bytes held by cached tiles
+};
+
+// An image stored on disk as square tiles, which are read into an LRU cache
+// only when pixels on them are accessed.  The cache holds at most
+// maxCachedBytes of tiles (but always at least one); modified tiles are
+// written back when they are evicted, when flush() is called, and when the
+// last copy of the TiledImage is destroyed.
+//
+// Copies share the same file and cache, and all methods are thread-safe.
+// Pixels outside the file's tiles are never stored; regions extending past
+// the bounding box read as zero.
+template <typename T>
+class TiledImage {
+public:
+
+    // Create (or truncate) a file holding an image with the given bounding
+    // box, with all pixels zero.
+    static TiledImage create(std::string const & path, IndexBox const & bbox, Index tileSize=256,
+                             std::size_t maxCachedBytes=(std::size_t(1) << 28));
+
+    static TiledImage open(std::string const & path, bool writable=false,
+                           std::size_t maxCachedBytes=(std::size_t(1) << 28));
+
+    IndexBox const & bbox() const;
+
+    Index tileSize() const;
+
+    bool isWritable() const;
+
+    // Return the bounding box of the tile that holds the given pixel,
+    // clipped to the image's bounding box.
+    IndexBox getTileBBox(Index2 const & index) const;
+
+    // Return a new in-memory image with the given bounding box, filled from
+    // the tiles it overlaps.
+    Image<T> read(IndexBox const & box) const;
+
+    // Copy the part of the given image that overlaps the bounding box into
+    // the tiles.
+    void write(Image<T const> const & image) const;
+
+    // Write all modified tiles back to the file.
+    void flush() const;
+
+    TileCacheStats stats() const;
+
+private:
+
+    class Impl;
+
+    explicit TiledImage(std::shared_ptr<Impl> impl) : _impl(std::move(impl)) {}
+
+    std::shared_ptr<Impl> _impl;
+};
+
+
+// Warp a tiled image with the given interpolant, one output tile at a time,
+// reading only the input pixels within the interpolant's footprint of each
+// output tile.  The transform maps output coordinates to input coordinates,
+// as in Interpolant::warp.  At most one tile of output and the input region
+// it needs are held in memory beyond the two tile caches.
+void warp(
+    Interpolant const & interpolant,
+    TiledImage<float> const & input,
+    Affine const & transform,
+    TiledImage<float> const & output
+);
+
+// Convolve (or correlate, if transpose is true) a tiled image with a kernel,
+// one output tile at a time, as in Kernel::convolve.
+void convolve(
+    Kernel const & kernel,
+    TiledImage<float> const & input,
+    Affine const & transform,
+    TiledImage<float> const & output,
+    bool transpose=false
+);
+
+} // namespace cipells
+
+#endif // !CIPELLS_TiledImage_h_INCLUDED
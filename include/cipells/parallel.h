@@ -0,0 +1,57 @@
+#ifndef CIPELLS_parallel_h_INCLUDED
+#define CIPELLS_parallel_h_INCLUDED
+
+#include <functional>
+#include <utility>
+
+#include "cipells/common.h"
+#include "cipells/Box.h"
+
+namespace cipells {
+
+// Set the number of threads used by operations that split their output into
+// independent bands or tiles.  A value of one (the default) runs everything
+// in the calling thread; zero selects the number of hardware threads.
+void setThreadCount(Index n);
+
+Index getThreadCount();
+
+namespace detail {
+
+// Call func(i) for each i in [0, n) on the library's thread pool, returning
+// only when all calls have completed.  Calls made from within a pool task run
+// serially in that task's thread.
+void parallelFor(Index n, std::function<void(Index)> const & func);
+
+} // namespace detail
+
+// Number of rows in each band of the overload of forEachRowBand without an
+// explicit band height, which is what most parallel operations use.
+constexpr Index DEFAULT_BAND_HEIGHT = 64;
+
+// Split the given box into bands of at most bandHeight rows and call
+// func(band) for each, in parallel when more than one thread is enabled.
+// The partitioning does not depend on the number of threads.
+template <typename Func>
+void forEachRowBand(IndexBox const & box, Index bandHeight, Func func) {
+    if (box.isEmpty()) {
+        return;
+    }
+    Index nBands = (box.height() + bandHeight - 1)/bandHeight;
+    detail::parallelFor(
+        nBands,
+        [&box, bandHeight, &func](Index i) {
+            IndexInterval rows = IndexInterval::fromMinSize(box.y0() + i*bandHeight, bandHeight);
+            func(IndexBox(box.x(), rows.clipTo(box.y())));
+        }
+    );
+}
+
+template <typename Func>
+void forEachRowBand(IndexBox const & box, Func func) {
+    forEachRowBand(box, DEFAULT_BAND_HEIGHT, std::move(func));
+}
+
+} // namespace cipells
+
+#endif // !CIPELLS_parallel_h_INCLUDED
@@ -1,24 +1,93 @@
 #ifndef CIPELLS_profiles_h_INCLUDED
 #define CIPELLS_profiles_h_INCLUDED
 
+#include <complex>
+#include <vector>
+
 #include "cipells/fwd/Image.h"
 #include "cipells/transforms.h"
 #include "cipells/formatting.h"
 
 namespace cipells {
 
+class Kernel;
+
 class Gaussian : public detail::Formattable<Gaussian> {
 public:
 
+    // How addTo computes pixel values: SAMPLE evaluates the profile at pixel
+    // centers, while INTEGRATE averages it over the area of each pixel (i.e.
+    // draws the profile convolved with the pixel response), which remains
+    // unbiased for undersampled profiles.
+    enum class DrawMethod { SAMPLE, INTEGRATE };
+
     explicit Gaussian(Affine const & transform, double flux=1.0);
 
     double operator()(Real2 const & xy) const;
 
     double operator()(Real x, Real y) const { return (*this)(Real2(x, y)); }
 
+    // Evaluate the Fourier transform of the profile,
+    // F(k) = \int f(x) e^{-i k.x} d^2x, at a wavevector in radians per pixel.
+    std::complex<double> kValue(Real2 const & k) const;
+
+    std::complex<double> kValue(Real kx, Real ky) const { return kValue(Real2(kx, ky)); }
+
+    // Default number of standard deviations (along each principal axis) out
+    // to which addTo draws the profile; the flux beyond it is a fraction
+    // exp(-n^2/2) (about 1.5E-8) of the total.
+    static constexpr Real DEFAULT_N_SIGMA = 6.0;
+
+    // Transform from the unit circular Gaussian to this profile.
+    Affine const & transform() const { return _transform; }
+
+    double flux() const { return _flux; }
+
     Gaussian transformedBy(Affine const & t) const;
 
-    void addTo(Image<float> & image) const;
+    // Return the convolution of this profile with another, which is a
+    // Gaussian whose covariance and center are the sums of theirs and whose
+    // flux is the product of theirs.
+    Gaussian convolvedWith(Gaussian const & other) const;
+
+    // Return the bounding box of the ellipse nSigma standard deviations from
+    // the center.
+    RealBox computeBBox(Real nSigma=DEFAULT_N_SIGMA) const;
+
+    // Return the box containing all pixels that addTo may modify (when given
+    // an image that contains it).
+    IndexBox computeFootprint(Real nSigma=DEFAULT_N_SIGMA, DrawMethod method=DrawMethod::SAMPLE) const;
+
+    // Add the profile to the pixels of the image whose centers are within
+    // nSigma standard deviations of the center (or, with INTEGRATE, that
+    // overlap that ellipse).
+    void addTo(
+        Image<float> const & image,
+        Real nSigma=DEFAULT_N_SIGMA,
+        DrawMethod method=DrawMethod::SAMPLE
+    ) const;
+
+    // Add the Fourier transform of the profile to an image on a k-space
+    // grid, with pixel (i, j) at wavevector (i*kStep.x, j*kStep.y).  With
+    // INTEGRATE, the transform is multiplied by that of the pixel response.
+    void addKTo(
+        Image<std::complex<float>> const & image,
+        Real2 const & kStep,
+        DrawMethod method=DrawMethod::SAMPLE
+    ) const;
+
+    // Add the profile convolved with a pixelized PSF (which must not be
+    // upsampled) to the image, as the inverse FFT of the product of their
+    // Fourier transforms; the result is the same as drawing the profile with
+    // addTo and convolving it with Kernel::convolve, but the profile is
+    // drawn directly in k-space.  The FFT grid covers the image, padded by
+    // the kernel, and the nSigma footprint of the profile.
+    void addConvolvedTo(
+        Kernel const & psf,
+        Image<float> const & image,
+        Real nSigma=DEFAULT_N_SIGMA,
+        DrawMethod method=DrawMethod::SAMPLE
+    ) const;
 
     void format(detail::Writer & writer, detail::FormatSpec const & spec) const;
 
@@ -28,6 +97,93 @@ private:
     double _flux;
 };
 
+// A sum of Gaussians, e.g. an approximation to a Sersic profile, which can
+// be convolved analytically with Gaussian or mixture PSFs and drawn with all
+// components in a single pass over the image.
+class GaussianMixture : public detail::Formattable<GaussianMixture> {
+public:
+
+    explicit GaussianMixture(std::vector<Gaussian> components);
+
+    double operator()(Real2 const & xy) const;
+
+    double operator()(Real x, Real y) const { return (*this)(Real2(x, y)); }
+
+    std::complex<double> kValue(Real2 const & k) const;
+
+    std::complex<double> kValue(Real kx, Real ky) const { return kValue(Real2(kx, ky)); }
+
+    std::vector<Gaussian> const & components() const { return _components; }
+
+    // Total flux of all components.
+    double flux() const;
+
+    GaussianMixture transformedBy(Affine const & t) const;
+
+    // Return the convolution of this profile with a PSF, which has one
+    // component for each pair of components in the profile and the PSF.
+    GaussianMixture convolvedWith(Gaussian const & psf) const;
+    GaussianMixture convolvedWith(GaussianMixture const & psf) const;
+
+    // Return the union of the components' footprints.
+    IndexBox computeFootprint(
+        Real nSigma=Gaussian::DEFAULT_N_SIGMA,
+        Gaussian::DrawMethod method=Gaussian::DrawMethod::SAMPLE
+    ) const;
+
+    // Add all components to the image, each within its own footprint as in
+    // Gaussian::addTo.
+    void addTo(
+        Image<float> const & image,
+        Real nSigma=Gaussian::DEFAULT_N_SIGMA,
+        Gaussian::DrawMethod method=Gaussian::DrawMethod::SAMPLE
+    ) const;
+
+    // See Gaussian::addKTo.
+    void addKTo(
+        Image<std::complex<float>> const & image,
+        Real2 const & kStep,
+        Gaussian::DrawMethod method=Gaussian::DrawMethod::SAMPLE
+    ) const;
+
+    // See Gaussian::addConvolvedTo.
+    void addConvolvedTo(
+        Kernel const & psf,
+        Image<float> const & image,
+        Real nSigma=Gaussian::DEFAULT_N_SIGMA,
+        Gaussian::DrawMethod method=Gaussian::DrawMethod::SAMPLE
+    ) const;
+
+    void format(detail::Writer & writer, detail::FormatSpec const & spec) const;
+
+private:
+    std::vector<Gaussian> _components;
+};
+
+// Width and height of the tiles into which renderGaussians divides images.
+constexpr Index RENDER_TILE_SIZE = 256;
+
+// Add many profiles to an image; equivalent to calling addTo for each, but
+// with the profiles binned into square tiles of the image by their
+// footprints and the tiles drawn in parallel.  Each tile is drawn by a single
+// thread, in catalog order, so the result does not depend on the number of
+// threads.
+void renderGaussians(
+    std::vector<Gaussian> const & profiles,
+    Image<float> const & image,
+    Real nSigma=Gaussian::DEFAULT_N_SIGMA,
+    Gaussian::DrawMethod method=Gaussian::DrawMethod::SAMPLE,
+    Index tileSize=RENDER_TILE_SIZE
+);
+
+void renderGaussians(
+    std::vector<GaussianMixture> const & profiles,
+    Image<float> const & image,
+    Real nSigma=Gaussian::DEFAULT_N_SIGMA,
+    Gaussian::DrawMethod method=Gaussian::DrawMethod::SAMPLE,
+    Index tileSize=RENDER_TILE_SIZE
+);
+
 } // namespace cipells
 
 #endif // ! CIPELLS_profiles_h_INCLUDED
@@ -42,12 +42,28 @@ utils::Deferrer pyTransforms(pybind11::module & module);
 
 utils::Deferrer pyImage(pybind11::module & module);
 
+utils::Deferrer pyImageStack(pybind11::module & module);
+
+utils::Deferrer pyMaskedImage(pybind11::module & module);
+
+utils::Deferrer pyImageAllocator(pybind11::module & module);
+
 utils::Deferrer pyInterpolant(pybind11::module & module);
 
 utils::Deferrer pyKernel(pybind11::module & module);
 
+utils::Deferrer pyMappedFile(pybind11::module & module);
+
+utils::Deferrer pyTiledImage(pybind11::module & module);
+
+utils::Deferrer pyStreamingWarp(pybind11::module & module);
+
+utils::Deferrer pyStatistics(pybind11::module & module);
+
 utils::Deferrer pyProfiles(pybind11::module & module);
 
+utils::Deferrer pyParallel(pybind11::module & module);
+
 } // namespace cipells
 
 #endif // !CIPELLS_python_h_INCLUDED
@@ -3,7 +3,7 @@
 
 #include "pybind11/pybind11.h"
 
-#include "cipells/fwd/Image.h"
+#include "cipells/Image.h"
 
 namespace cipells {
 
@@ -86,6 +86,27 @@ private:
     Proxy _proxy;
 };
 
+// Half-precision pixels are exchanged with Python as ordinary floats.
+template <>
+struct type_caster<cipells::Half> {
+public:
+
+    PYBIND11_TYPE_CASTER(cipells::Half, _("float"));
+
+    bool load(handle src, bool convert) {
+        type_caster<float> caster;
+        if (!caster.load(src, convert)) {
+            return false;
+        }
+        value = cipells::Half(static_cast<float>(caster));
+        return true;
+    }
+
+    static handle cast(cipells::Half const & src, return_value_policy, handle) {
+        return PyFloat_FromDouble(static_cast<float>(src));
+    }
+};
+
 }} // namespace pybind11::detail
 
 #endif // !CIPELLS_PYTHON_Image_h_INCLUDED
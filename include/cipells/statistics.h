@@ -0,0 +1,72 @@
+#ifndef CIPELLS_statistics_h_INCLUDED
+#define CIPELLS_statistics_h_INCLUDED
+
+#include <vector>
+
+#include "Eigen/Core"
+#include "cipells/Image.h"
+
+namespace cipells {
+
+// Reductions over the pixels of an image (or a subimage view of one).
+//
+// Each is a single pass over the image, with the pixels of each row summed
+// (in double precision) by vectorized Eigen reductions.  Rows are summed in
+// parallel when more than one thread is enabled (see setThreadCount), and
+// the row sums are then combined pairwise in a fixed order, so results are
+// identical for any number of threads.  NaN pixels propagate to the results.
+//
+// The batched overloads process many stamps at once, in parallel over
+// stamps.
+
+// Summary statistics of the values of the pixels of an image.
+struct ImageStatistics {
+    Index count;
+    double sum;
+    double mean;
+    double variance;    // population variance, i.e. normalized by count
+    double min;
+    double max;
+};
+
+// Flux-weighted moments of the positions of the pixels of an image.
+struct ImageMoments {
+    double flux;                    // sum of all pixels
+    Real2 centroid;                 // flux-weighted mean position
+    Eigen::Matrix2d secondMoments;  // flux-weighted covariance of position about the centroid
+};
+
+// Mean and standard deviation of the pixels of an image after iteratively
+// rejecting those more than nSigma standard deviations from the mean.
+struct ClippedStatistics {
+    Index count;        // number of pixels not rejected
+    double mean;
+    double stddev;
+    int iterations;     // number of clipping iterations done
+};
+
+template <typename T>
+ImageStatistics computeStatistics(Image<T const> const & image);
+
+template <typename T>
+std::vector<ImageStatistics> computeStatistics(std::vector<Image<T const>> const & images);
+
+template <typename T>
+ImageMoments computeMoments(Image<T const> const & image);
+
+template <typename T>
+std::vector<ImageMoments> computeMoments(std::vector<Image<T const>> const & images);
+
+// Clipping stops when an iteration rejects no more pixels, or after
+// maxIterations iterations.
+template <typename T>
+ClippedStatistics computeClippedStatistics(Image<T const> const & image, double nSigma=3.0,
+                                           int maxIterations=5);
+
+template <typename T>
+std::vector<ClippedStatistics> computeClippedStatistics(std::vector<Image<T const>> const & images,
+                                                        double nSigma=3.0, int maxIterations=5);
+
+} // namespace cipells
+
+#endif // !CIPELLS_statistics_h_INCLUDED
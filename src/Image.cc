@@ -1,18 +1,23 @@
 #define CIPELLS_Image_cc_SRC
 #include "cipells/Image.h"
+#include "cipells/ImageAllocator.h"
 
 namespace cipells {
 
 namespace {
 
-template <typename T>
-T div_ceil(T x, T y) {
-    return x/y + (x % y != 0);
+ImageOwner allocate(std::size_t item_size, Index area) {
+    return getImageAllocator()->allocate(area*item_size);
 }
 
-ImageOwner allocate(std::size_t item_size, Index area) {
-    return ImageOwner(new ImageStorage[div_ceil(area*item_size, sizeof(ImageStorage))],
-                      std::default_delete<ImageStorage[]>());
+template <typename T>
+Index computeStride(Index width, ImageLayout layout) {
+    static_assert(IMAGE_ALIGNMENT % sizeof(T) == 0, "Pixel size must divide the image alignment.");
+    if (layout == ImageLayout::PADDED) {
+        Index const n = IMAGE_ALIGNMENT/sizeof(T);
+        return (width + n - 1)/n*n;
+    }
+    return width;
 }
 
 } // anonymous
@@ -26,9 +31,9 @@ Image<T const>::Image(T const * data, IndexBox const & bbox, ImageOwner owner, I
 {}
 
 template <typename T>
-Image<T const>::Image(IndexBox const & box) :
-    _data(nullptr), _stride(box.width()),
-    _owner(allocate(sizeof(T), box.area())),
+Image<T const>::Image(IndexBox const & box, ImageLayout layout) :
+    _data(nullptr), _stride(computeStride<T>(box.width(), layout)),
+    _owner(allocate(sizeof(T), _stride*box.height())),
     _bbox(box)
 {
     _data = reinterpret_cast<T const*>(_owner.get());
@@ -65,7 +70,10 @@ Image<T const> & Image<T const>::operator=(Image && other) {
 
 template <typename T>
 Image<T> Image<T const>::copy() const {
-    Image<T> result(this->bbox());
+    Image<T> result = Image<T>::makeUninitialized(
+        this->bbox(),
+        hasAlignedRows() ? ImageLayout::PADDED : ImageLayout::COMPACT
+    );
     result.array() = this->array();
     return result;
 }
@@ -83,7 +91,7 @@ Image<T const> Image<T const>::freeze() && {
 }
 
 template <typename T>
-Image<T>::Image(IndexBox const & box) : Base(box) {
+Image<T>::Image(IndexBox const & box, ImageLayout layout) : Base(box, layout) {
     array().setZero();
 }
 
@@ -91,5 +99,13 @@ template class Image<float const>;
 template class Image<float>;
 template class Image<std::complex<float> const>;
 template class Image<std::complex<float>>;
+template class Image<double const>;
+template class Image<double>;
+template class Image<std::uint16_t const>;
+template class Image<std::uint16_t>;
+template class Image<std::int32_t const>;
+template class Image<std::int32_t>;
+template class Image<Half const>;
+template class Image<Half>;
 
 } // namespace cipells
@@ -0,0 +1,261 @@
+#define CIPELLS_ImageAllocator_cc_SRC
+
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#include "cipells/ImageAllocator.h"
+
+namespace cipells {
+
+namespace {
+
+// Smallest size class, in bytes.
+constexpr std::size_t MIN_BLOCK_SIZE = 256;
+
+// Storage aligned to IMAGE_ALIGNMENT within a (slightly larger) raw
+// allocation.
+struct Block {
+    void * raw;
+    ImageStorage * aligned;
+    std::size_t size;
+};
+
+Block allocateBlock(std::size_t size) {
+    Block result;
+    result.raw = ::operator new(size + IMAGE_ALIGNMENT);
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(result.raw) + IMAGE_ALIGNMENT - 1;
+    result.aligned = reinterpret_cast<ImageStorage*>(address - address % IMAGE_ALIGNMENT);
+    result.size = size;
+    return result;
+}
+
+void freeBlock(Block const & block) {
+    ::operator delete(block.raw);
+}
+
+// Round a request up to the next multiple of a quarter of the largest power
+// of two that does not exceed it, so each class is at most 25% larger than
+// the requests it serves.
+std::size_t computeSizeClass(std::size_t bytes) {
+    if (bytes <= MIN_BLOCK_SIZE) {
+        return MIN_BLOCK_SIZE;
+    }
+    std::size_t step = MIN_BLOCK_SIZE;
+    while (2*step <= bytes) {
+        step *= 2;
+    }
+    step /= 4;
+    return (bytes + step - 1)/step*step;
+}
+
+// Allocator for the control blocks of ImageOwners that recycles them
+// through a free list, so reusing pooled storage doesn't touch the heap.
+template <typename T>
+class RecyclingAllocator {
+public:
+
+    using value_type = T;
+
+    RecyclingAllocator() = default;
+
+    template <typename U>
+    RecyclingAllocator(RecyclingAllocator<U> const &) {}
+
+    T * allocate(std::size_t n) {
+        if (n == 1) {
+            FreeList & list = getFreeList();
+            std::lock_guard<std::mutex> lock(list.mutex);
+            if (!list.items.empty()) {
+                void * result = list.items.back();
+                list.items.pop_back();
+                return static_cast<T*>(result);
+            }
+        }
+        return static_cast<T*>(::operator new(n*sizeof(T)));
+    }
+
+    void deallocate(T * p, std::size_t n) {
+        if (n == 1) {
+            FreeList & list = getFreeList();
+            std::lock_guard<std::mutex> lock(list.mutex);
+            list.items.push_back(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(RecyclingAllocator<U> const &) const { return true; }
+
+    template <typename U>
+    bool operator!=(RecyclingAllocator<U> const &) const { return false; }
+
+private:
+
+    struct FreeList {
+        std::mutex mutex;
+        std::vector<void*> items;
+    };
+
+    static FreeList & getFreeList() {
+        // Never destroyed, since images may outlive static destruction.
+        static FreeList * instance = new FreeList();
+        return *instance;
+    }
+};
+
+
+class HeapAllocator : public ImageAllocator, public std::enable_shared_from_this<HeapAllocator> {
+public:
+
+    HeapAllocator() : _stats() {}
+
+    ImageOwner allocate(std::size_t bytes) override {
+        Block block = allocateBlock(bytes);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_stats.allocations;
+            _stats.bytesInUse += block.size;
+        }
+        auto self = shared_from_this();
+        return ImageOwner(
+            block.aligned,
+            [self, block](ImageStorage const *) { self->release(block); },
+            RecyclingAllocator<ImageStorage>()
+        );
+    }
+
+    ImageAllocationStats stats() const override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+private:
+
+    void release(Block const & block) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.bytesInUse -= block.size;
+        }
+        freeBlock(block);
+    }
+
+    mutable std::mutex _mutex;
+    ImageAllocationStats _stats;
+};
+
+
+class PoolAllocator : public ImageAllocator, public std::enable_shared_from_this<PoolAllocator> {
+public:
+
+    explicit PoolAllocator(std::size_t maxCachedBytes) : _maxCachedBytes(maxCachedBytes), _stats() {}
+
+    ImageOwner allocate(std::size_t bytes) override {
+        std::size_t const size = computeSizeClass(bytes);
+        Block block = {nullptr, nullptr, size};
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_stats.allocations;
+            _stats.bytesInUse += size;
+            auto iter = _cache.find(size);
+            if (iter != _cache.end() && !iter->second.empty()) {
+                block = iter->second.back();
+                iter->second.pop_back();
+                _stats.bytesCached -= size;
+                ++_stats.reused;
+            }
+        }
+        if (!block.raw) {
+            try {
+                block = allocateBlock(size);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                --_stats.allocations;
+                _stats.bytesInUse -= size;
+                throw;
+            }
+        }
+        auto self = shared_from_this();
+        return ImageOwner(
+            block.aligned,
+            [self, block](ImageStorage const *) { self->release(block); },
+            RecyclingAllocator<ImageStorage>()
+        );
+    }
+
+    ImageAllocationStats stats() const override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    void trim() override {
+        std::unordered_map<std::size_t, std::vector<Block>> cache;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            cache.swap(_cache);
+            _stats.bytesCached = 0;
+        }
+        for (auto const & item : cache) {
+            for (auto const & block : item.second) {
+                freeBlock(block);
+            }
+        }
+    }
+
+    ~PoolAllocator() {
+        trim();
+    }
+
+private:
+
+    void release(Block const & block) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.bytesInUse -= block.size;
+            if (_stats.bytesCached + block.size <= _maxCachedBytes) {
+                _cache[block.size].push_back(block);
+                _stats.bytesCached += block.size;
+                return;
+            }
+        }
+        freeBlock(block);
+    }
+
+    std::size_t const _maxCachedBytes;
+    mutable std::mutex _mutex;
+    std::unordered_map<std::size_t, std::vector<Block>> _cache;
+    ImageAllocationStats _stats;
+};
+
+
+std::shared_ptr<ImageAllocator> & getGlobalAllocator() {
+    static std::shared_ptr<ImageAllocator> instance = ImageAllocator::makeHeap();
+    return instance;
+}
+
+} // anonymous
+
+
+std::shared_ptr<ImageAllocator> ImageAllocator::makeHeap() {
+    return std::make_shared<HeapAllocator>();
+}
+
+std::shared_ptr<ImageAllocator> ImageAllocator::makePool(std::size_t maxCachedBytes) {
+    return std::make_shared<PoolAllocator>(maxCachedBytes);
+}
+
+void setImageAllocator(std::shared_ptr<ImageAllocator> allocator) {
+    if (!allocator) {
+        allocator = ImageAllocator::makeHeap();
+    }
+    std::atomic_store(&getGlobalAllocator(), std::move(allocator));
+}
+
+std::shared_ptr<ImageAllocator> getImageAllocator() {
+    return std::atomic_load(&getGlobalAllocator());
+}
+
+} // namespace cipells
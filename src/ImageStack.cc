@@ -0,0 +1,101 @@
+#define CIPELLS_ImageStack_cc_SRC
+
+#include <stdexcept>
+
+#include "cipells/ImageStack.h"
+
+namespace cipells {
+
+template <typename T>
+ImageStack<T>::ImageStack() :
+    _data(nullptr), _bbox(), _planeCount(0), _layout(StackLayout::PLANAR),
+    _rowStride(0), _pixelStride(1), _planeStride(0), _owner(nullptr)
+{}
+
+template <typename T>
+ImageStack<T>::ImageStack(IndexBox const & bbox, Index planeCount, StackLayout layout) :
+    ImageStack()
+{
+    if (planeCount < 1) {
+        throw std::invalid_argument("Image stacks must have at least one plane.");
+    }
+    // The pixels are allocated as a single padded image, with the planes
+    // stacked vertically or the pixels of each row interleaved horizontally.
+    Image<T> storage(
+        layout == StackLayout::PLANAR ?
+            IndexBox::fromMinSize(Index2(0, 0), Index2(bbox.width(), bbox.height()*planeCount)) :
+            IndexBox::fromMinSize(Index2(0, 0), Index2(bbox.width()*planeCount, bbox.height())),
+        ImageLayout::PADDED
+    );
+    _data = storage.data();
+    _bbox = bbox;
+    _planeCount = planeCount;
+    _layout = layout;
+    _rowStride = storage.stride();
+    if (layout == StackLayout::PLANAR) {
+        _pixelStride = 1;
+        _planeStride = storage.stride()*bbox.height();
+    } else {
+        _pixelStride = planeCount;
+        _planeStride = 1;
+    }
+    _owner = storage.owner();
+}
+
+template <typename T>
+ImageStack<T>::ImageStack(T * data, IndexBox const & bbox, Index planeCount, StackLayout layout,
+                          Index rowStride, Index planeStride, ImageOwner owner) :
+    _data(data), _bbox(bbox), _planeCount(planeCount), _layout(layout),
+    _rowStride(rowStride), _pixelStride(layout == StackLayout::PLANAR ? 1 : planeCount),
+    _planeStride(planeStride), _owner(std::move(owner))
+{}
+
+template <typename T>
+ImageStack<T>::ImageStack(ImageStack const &) = default;
+
+template <typename T>
+ImageStack<T>::ImageStack(ImageStack &&) = default;
+
+template <typename T>
+ImageStack<T> & ImageStack<T>::operator=(ImageStack const &) = default;
+
+template <typename T>
+ImageStack<T> & ImageStack<T>::operator=(ImageStack &&) = default;
+
+template <typename T>
+ImageStack<T>::~ImageStack() {}
+
+template <typename T>
+ImageStack<T> ImageStack<T>::operator[](IndexBox const & box) const {
+    assert(bbox().contains(box));
+    return ImageStack(_data + _offset(box.min()), box, _planeCount, _layout, _rowStride, _planeStride, _owner);
+}
+
+template <typename T>
+Image<T> ImageStack<T>::operator[](Index plane) const {
+    if (_layout != StackLayout::PLANAR) {
+        throw std::logic_error("Planes of interleaved image stacks cannot be viewed as images.");
+    }
+    assert(plane >= 0 && plane < planeCount());
+    return Image<T>(_data + plane*_planeStride, _bbox, _owner, _rowStride);
+}
+
+template <typename T>
+Image<T> ImageStack<T>::copyPlane(Index plane) const {
+    auto result = Image<T>::makeUninitialized(_bbox, ImageLayout::PADDED);
+    result.array() = array(plane);
+    return result;
+}
+
+template <typename T>
+void ImageStack<T>::setPlane(Index plane, Image<T const> const & image) const {
+    IndexBox box = image.bbox().clippedTo(_bbox);
+    array(plane, box) = image.array(box);
+}
+
+template class ImageStack<float>;
+template class ImageStack<double>;
+template class ImageStack<std::uint16_t>;
+template class ImageStack<Half>;
+
+} // namespace cipells
@@ -1,36 +1,211 @@
 #define CIPELLS_Interpolant_cc_SRC
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <limits>
+#include <stdexcept>
+#include <vector>
 
 #include "cipells/Interpolant.h"
+#include "cipells/parallel.h"
+#include "impl/fft.h"
+#include "impl/upsampling.h"
 
 namespace cipells {
 
 namespace {
 
+// Size (in output pixels) of the square tiles InterpolantImpl::convolve
+// processes at once; chosen so an upsampled intermediate tile stays in cache.
+constexpr Index INTERPOLANT_TILE_SIZE = 32;
+
+// Maximum number of positions InterpolantImpl evaluates at once.
+constexpr Index EVALUATE_CHUNK_SIZE = 16;
+
+// Adapts one plane of an ImageStack to the parts of the Image interface
+// used by InterpolantImpl's templates.
+struct StackPlane {
+    ImageStack<float> const & stack;
+    Index plane;
+
+    IndexBox const & bbox() const { return stack.bbox(); }
+
+    ImageStack<float>::Array array(IndexBox const & box) const { return stack.array(plane, box); }
+};
+
+void checkStacks(ImageStack<float> const & input, ImageStack<float> const & output) {
+    if (input.planeCount() != output.planeCount()) {
+        throw std::invalid_argument("Input and output image stacks must have the same number of planes.");
+    }
+}
+
+// Band-limited (sinc) resampling of periodic sequences along one dimension,
+// via a phase ramp and (for upsampling) zero-padding in Fourier space.  The
+// ramp is computed once and shared by all of the rows (or columns) resampled
+// with the same axis; each task supplies its own Workspace.
+class FourierAxis {
+public:
+
+    // Buffers reused across calls to apply within a single task.
+    struct Workspace {
+        std::vector<float> values;
+        std::vector<std::complex<float>> buffer;
+        std::vector<std::complex<float>> padded;
+        std::vector<std::complex<float>> result;
+    };
+
+    // Return true if a transform with the given (diagonal) scale along this
+    // axis can be evaluated in Fourier space, setting the upsampling factor
+    // and the step between output samples on the upsampled grid.
+    static bool getFactors(Real scale, Index & upsampling, Index & step) {
+        if (scale >= 1.0) {
+            upsampling = 1;
+            step = std::lround(scale);
+            return std::fabs(scale - step) < 1E-10*scale;
+        }
+        if (scale > 0.0) {
+            upsampling = std::lround(1.0/scale);
+            step = 1;
+            return std::fabs(1.0/scale - upsampling) < 1E-10/scale;
+        }
+        return false;
+    }
+
+    // Prepare to resample an input interval at positions scale*i + offset
+    // for each i in the output interval.
+    FourierAxis(
+        IndexInterval const & input,
+        IndexInterval const & output,
+        Index upsampling,
+        Index step,
+        Real scale,
+        Real offset
+    ) : _n(input.size()), _upsampling(upsampling), _step(step), _size(output.size()),
+        _start(0), _ramp(input.size())
+    {
+        // Output sample i lands at upsampled index (step*i + c), with c split
+        // into an integer start and a fractional shift applied as a phase ramp.
+        Real c = upsampling*(scale*output.min() + offset - input.min());
+        Real start = std::floor(c);
+        Real shift = (c - start)/upsampling;
+        _start = static_cast<Index>(start);
+        for (Index k = 0; k < _n; ++k) {
+            Index freq = (2*k <= _n) ? k : k - _n;
+            _ramp[k] = std::polar(1.0, 2*M_PI*freq*shift/_n);
+        }
+    }
+
+    // Resample n input values separated by the given stride (converting
+    // them to float), writing the output values with the given stride.
+    template <typename T>
+    void apply(T const * input, Index inputStride, float * output, Index outputStride,
+               Workspace & ws) const {
+        detail::FFT & fft = detail::getFFT();
+        Index const m = _upsampling*_n;
+        ws.values.resize(_n);
+        ws.buffer.resize(_n);
+        ws.padded.assign(m, std::complex<float>(0.0f));
+        ws.result.resize(m);
+        for (Index i = 0; i < _n; ++i) {
+            ws.values[i] = static_cast<float>(input[i*inputStride]);
+        }
+        fft.fwd(ws.buffer.data(), ws.values.data(), _n);
+        for (Index k = 0; k < _n; ++k) {
+            std::complex<float> value = ws.buffer[k]*std::complex<float>(_ramp[k]);
+            if (2*k == _n) {
+                // Split the Nyquist frequency evenly between +n/2 and -n/2,
+                // which makes its contribution real.
+                if (_upsampling == 1) {
+                    ws.padded[k] += std::complex<float>(ws.buffer[k]*float(_ramp[k].real()));
+                } else {
+                    ws.padded[k] += 0.5f*value;
+                    ws.padded[m - k] += 0.5f*ws.buffer[k]*std::complex<float>(std::conj(_ramp[k]));
+                }
+            } else {
+                Index freq = (2*k < _n) ? k : k - _n;
+                ws.padded[(freq + m) % m] = value;
+            }
+        }
+        fft.inv(ws.result.data(), ws.padded.data(), m);
+        for (Index i = 0; i < _size; ++i) {
+            Index j = ((_step*i + _start) % m + m) % m;
+            output[i*outputStride] = ws.result[j].real()/_n;
+        }
+    }
+
+private:
+    Index _n;
+    Index _upsampling;
+    Index _step;
+    Index _size;
+    Index _start;
+    std::vector<std::complex<double>> _ramp;
+};
+
+
 template <typename Derived>
 class InterpolantImpl : public Interpolant {
 public:
 
     using Array = Eigen::Array<float, Eigen::Dynamic, 1>;
+    using Chunk = Eigen::Array<float, Eigen::Dynamic, 1, 0, EVALUATE_CHUNK_SIZE, 1>;
+
+    // Upper bound on the number of pixels in a footprint, if known at
+    // compile time; derived classes may shadow this to keep their weight
+    // arrays on the stack.
+    static constexpr Index MAX_FOOTPRINT = Eigen::Dynamic;
 
     explicit InterpolantImpl(Real radius) :
-        _radius(2*radius)
+        _radius(radius)
     {}
 
+    // Compute the weights for the input pixels in the given interval at
+    // position x.  Derived classes may shadow this with a faster version.
     void fill(float x, IndexInterval const & interval, float * output) const {
-        for (Index i = interval.min(); i <= interval.max(); ++i, ++output) {
-            *output = static_cast<Derived const *>(this)->evaluate(x - i);
+        Eigen::Map<Array> out(output, interval.size());
+        for (Index i = 0; i < interval.size(); ++i) {
+            out[i] = x - (interval.min() + i);
+        }
+        derived().evaluateArray(out, out);
+    }
+
+    // Evaluate the interpolant at each element of x (which may alias the
+    // output), in chunks small enough for derived classes to keep their
+    // temporaries on the stack.
+    template <typename In, typename Out>
+    void evaluateArray(In const & x, Out & output) const {
+        for (Index i = 0; i < x.size(); i += EVALUATE_CHUNK_SIZE) {
+            Chunk chunk = x.segment(i, std::min(EVALUATE_CHUNK_SIZE, Index(x.size() - i)));
+            derived().evaluateChunk(chunk);
+            output.segment(i, chunk.size()) = chunk;
+        }
+    }
+
+    // Evaluate the interpolant in-place at each element of the given chunk.
+    // Derived classes may shadow this with a vectorized version.
+    void evaluateChunk(Chunk & x) const {
+        for (Index i = 0; i < x.size(); ++i) {
+            x[i] = derived().evaluate(x[i]);
         }
     }
 
     Index computeArraySize(Index input_size) const {
-        return static_cast<Index>(std::min(2*std::ceil(_radius) + 1, static_cast<Real>(input_size)));
+        return static_cast<Index>(std::min(2*std::ceil(_radius) + 2, static_cast<Real>(input_size)));
     }
 
+    Real radius() const override { return _radius; }
+
     double operator()(double x) const override {
-        static_cast<Derived const *>(this)->evaluate(x);
+        return derived().evaluate(x);
+    }
+
+    void evaluate(
+        Eigen::Ref<Eigen::ArrayXf const> const & x,
+        Eigen::Ref<Eigen::ArrayXf> output
+    ) const override {
+        assert(x.size() == output.size());
+        derived().evaluateArray(x, output);
     }
 
     void convolve(
@@ -41,7 +216,29 @@ public:
         Image<float> const & output,
         bool transpose
     ) const override {
-        throw std::logic_error("Not implemented.");
+        convolveImpl(input, kernel, upsampling, transform, output, transpose);
+    }
+
+    void convolve(
+        Image<std::uint16_t const> const & input,
+        Image<float const> const & kernel,
+        Index upsampling,
+        Affine const & transform,
+        Image<float> const & output,
+        bool transpose
+    ) const override {
+        convolveImpl(input, kernel, upsampling, transform, output, transpose);
+    }
+
+    void convolve(
+        Image<Half const> const & input,
+        Image<float const> const & kernel,
+        Index upsampling,
+        Affine const & transform,
+        Image<float> const & output,
+        bool transpose
+    ) const override {
+        convolveImpl(input, kernel, upsampling, transform, output, transpose);
     }
 
     void warp(
@@ -49,28 +246,584 @@ public:
         Affine const & transform,
         Image<float> const & output
     ) const override {
-        Array kx(computeArraySize(input.bbox().width()));
-        Array ky(computeArraySize(input.bbox().height()));
-        auto func = [&input, &transform, &kx, &ky, this](Index2 const & out_index, float & out_pixel) {
-            Real2 in_pos = transform(Real2(out_index));
-            IndexBox box(RealBox::fromCenterSize(in_pos, Real2(2*_radius, 2*_radius)));
-            box.clipTo(input.bbox());
-            assert(box.x().size() <= kx.size());
-            assert(box.y().size() <= ky.size());
-            fill(in_pos.x(), box.x(), &kx.coeffRef(0));
-            fill(in_pos.y(), box.y(), &ky.coeffRef(0));
-            out_pixel = (
-                input.array(box) *
-                (
-                    ky.head(box.y().size()).matrix() *
-                    kx.head(box.x().size()).matrix().transpose()
-                ).array()
-            ).sum();
-        };
-        apply(output, func);
+        warpImpl(input, transform, output);
+    }
+
+    void warp(
+        Image<std::uint16_t const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const override {
+        warpImpl(input, transform, output);
+    }
+
+    void warp(
+        Image<Half const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const override {
+        warpImpl(input, transform, output);
+    }
+
+    void convolve(
+        ImageStack<float> const & input,
+        Image<float const> const & kernel,
+        Index upsampling,
+        Affine const & transform,
+        ImageStack<float> const & output,
+        bool transpose
+    ) const override {
+        checkStacks(input, output);
+        // As in convolveImpl, but each tile's upsampled intermediate is a
+        // stack, so the final warp computes its weights once for all planes.
+        Index const u = upsampling;
+        Affine const fine = transform.inverted().then(Jacobian::makeScaling(u));
+        IndexBox const fineBBox = detail::computeStuffedBBox(input.bbox(), kernel.bbox(), u);
+        detail::StuffedWeights const weights = detail::computeStuffedWeights(kernel, u, transpose);
+        forEachTile(
+            output.bbox(), fineBBox, fine,
+            [&](IndexBox const & tile, IndexBox const & region) {
+                if (region.isEmpty()) {
+                    for (Index p = 0; p < output.planeCount(); ++p) {
+                        output.array(p, tile).setZero();
+                    }
+                    return;
+                }
+                ImageStack<float> stuffed(region, input.planeCount());
+                for (Index p = 0; p < input.planeCount(); ++p) {
+                    convolveStuffed(StackPlane{input, p}, weights, kernel.bbox().min(), u, stuffed[p]);
+                }
+                InterpolantImpl::warpDirect(stuffed, fine, output[tile]);
+            }
+        );
+    }
+
+    void warp(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const override {
+        InterpolantImpl::warpDirect(input, transform, output);
+    }
+
+    void warp(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output
+    ) const override {
+        InterpolantImpl::warpDirect(input, transform, output);
+    }
+
+    void warpDirect(
+        Image<float const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const override {
+        warpImpl(input, transform, output);
+    }
+
+    void warpDirect(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output
+    ) const override {
+        checkStacks(input, output);
+        forEachRowBand(
+            output.bbox(),
+            [&](IndexBox const & band) { warpStackBand(input, transform, output[band]); }
+        );
+    }
+
+    void warpDirect(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const override {
+        forEachRowBand(
+            output.bbox(),
+            [&](IndexBox const & band) { warpMaskedBand(input, transform, output[band]); }
+        );
+    }
+
+    void warpConvolved(
+        Image<float const> const & image,
+        Image<MaskPixel const> const & mask,
+        Image<float const> const & variance,
+        Image<float const> const & weights,
+        Index upsampling,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const override {
+        if (image.bbox() != mask.bbox()) {
+            throw std::invalid_argument("Image and mask planes must have the same bounding box.");
+        }
+        forEachRowBand(
+            output.bbox(),
+            [&](IndexBox const & band) {
+                warpConvolvedBand(image, mask, variance, weights, upsampling, transform, output[band]);
+            }
+        );
     }
 
 private:
+
+    Derived const & derived() const { return static_cast<Derived const &>(*this); }
+
+    template <typename T>
+    void convolveImpl(
+        Image<T const> const & input,
+        Image<float const> const & kernel,
+        Index upsampling,
+        Affine const & transform,
+        Image<float> const & output,
+        bool transpose
+    ) const {
+        // Convolving with a kernel that is itself interpolated from an
+        // upsampled grid is equivalent to convolving the zero-stuffed
+        // upsampled input with the kernel image on that grid (which needs no
+        // interpolation weights at all), and then warping the result onto the
+        // output grid with this interpolant.  We do that one output tile at a
+        // time, so the upsampled intermediate image stays small.
+        Index const u = upsampling;
+        Affine const fine = transform.inverted().then(Jacobian::makeScaling(u));
+        IndexBox const fineBBox = detail::computeStuffedBBox(input.bbox(), kernel.bbox(), u);
+        detail::StuffedWeights const weights = detail::computeStuffedWeights(kernel, u, transpose);
+        forEachTile(
+            output.bbox(), fineBBox, fine,
+            [&](IndexBox const & tile, IndexBox const & region) {
+                if (region.isEmpty()) {
+                    output.array(tile).setZero();
+                    return;
+                }
+                Image<float> stuffed(region, ImageLayout::PADDED);
+                convolveStuffed(input, weights, kernel.bbox().min(), u, stuffed);
+                InterpolantImpl::warpDirect(stuffed, fine, output[tile]);
+            }
+        );
+    }
+
+    // Call func(tile, region) in parallel for each output tile (see
+    // detail::forEachStuffedTile).
+    template <typename Func>
+    void forEachTile(IndexBox const & output, IndexBox const & fineBBox, Affine const & fine, Func func) const {
+        detail::forEachStuffedTile(
+            output, fineBBox, fine, _radius, Index2(INTERPOLANT_TILE_SIZE, INTERPOLANT_TILE_SIZE), func
+        );
+    }
+
+    // Pixels of integer and half-precision inputs are converted to float
+    // as they are read, so no converted copy of the input is needed.
+    template <typename T>
+    void warpImpl(
+        Image<T const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const {
+        forEachRowBand(
+            output.bbox(),
+            [&](IndexBox const & band) { warpBand(input, transform, output[band]); }
+        );
+    }
+
+    template <typename T>
+    void warpBand(
+        Image<T const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const {
+        if (transform.matrix()(0, 1) == 0.0 && transform.matrix()(1, 0) == 0.0) {
+            // Translations and axis-aligned scalings are separable, and the
+            // weights along each dimension depend only on the column (or row).
+            warpSeparable(input, transform, output);
+            return;
+        }
+        using Weights = Eigen::Array<float, Eigen::Dynamic, 1, 0, Derived::MAX_FOOTPRINT, 1>;
+        Weights kx(computeArraySize(input.bbox().width()));
+        Weights ky(computeArraySize(input.bbox().height()));
+        auto func = [&input, &transform, &kx, &ky, this](Index y, IndexInterval const & x, float * row) {
+            for (Index i = 0; i < x.size(); ++i) {
+                Real2 in_pos = transform(Real2(x.min() + i, y));
+                IndexBox box(
+                    computeFootprint(in_pos.x(), input.bbox().x()),
+                    computeFootprint(in_pos.y(), input.bbox().y())
+                );
+                if (box.isEmpty()) {
+                    row[i] = 0.0f;
+                    continue;
+                }
+                assert(box.x().size() <= kx.size());
+                assert(box.y().size() <= ky.size());
+                derived().fill(in_pos.x(), box.x(), &kx.coeffRef(0));
+                derived().fill(in_pos.y(), box.y(), &ky.coeffRef(0));
+                row[i] = (
+                    input.array(box).template cast<float>() *
+                    (
+                        ky.head(box.y().size()).matrix() *
+                        kx.head(box.x().size()).matrix().transpose()
+                    ).array()
+                ).sum();
+            }
+        };
+        applyRows(output, func);
+    }
+
+    void warpStackBand(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output
+    ) const {
+        if (transform.matrix()(0, 1) == 0.0 && transform.matrix()(1, 0) == 0.0) {
+            warpStackSeparable(input, transform, output);
+            return;
+        }
+        using Weights = Eigen::Array<float, Eigen::Dynamic, 1, 0, Derived::MAX_FOOTPRINT, 1>;
+        using Weights2 = Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor,
+                                      Derived::MAX_FOOTPRINT, Derived::MAX_FOOTPRINT>;
+        Weights kx(computeArraySize(input.bbox().width()));
+        Weights ky(computeArraySize(input.bbox().height()));
+        Weights2 w;
+        for (Index y = output.bbox().y0(); y <= output.bbox().y1(); ++y) {
+            for (Index x = output.bbox().x0(); x <= output.bbox().x1(); ++x) {
+                Index2 const out_index(x, y);
+                Real2 in_pos = transform(Real2(out_index));
+                IndexBox box(
+                    computeFootprint(in_pos.x(), input.bbox().x()),
+                    computeFootprint(in_pos.y(), input.bbox().y())
+                );
+                if (box.isEmpty()) {
+                    for (Index p = 0; p < output.planeCount(); ++p) {
+                        output(out_index, p) = 0.0f;
+                    }
+                    continue;
+                }
+                derived().fill(in_pos.x(), box.x(), &kx.coeffRef(0));
+                derived().fill(in_pos.y(), box.y(), &ky.coeffRef(0));
+                w = (ky.head(box.y().size()).matrix()*kx.head(box.x().size()).matrix().transpose()).array();
+                for (Index p = 0; p < output.planeCount(); ++p) {
+                    output(out_index, p) = (input.array(p, box)*w).sum();
+                }
+            }
+        }
+    }
+
+    void warpMaskedBand(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const {
+        if (transform.matrix()(0, 1) == 0.0 && transform.matrix()(1, 0) == 0.0) {
+            warpMaskedSeparable(input, transform, output);
+            return;
+        }
+        using Weights = Eigen::Array<float, Eigen::Dynamic, 1, 0, Derived::MAX_FOOTPRINT, 1>;
+        using Weights2 = Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor,
+                                      Derived::MAX_FOOTPRINT, Derived::MAX_FOOTPRINT>;
+        Weights kx(computeArraySize(input.bbox().width()));
+        Weights ky(computeArraySize(input.bbox().height()));
+        Weights2 w;
+        for (Index y = output.bbox().y0(); y <= output.bbox().y1(); ++y) {
+            for (Index x = output.bbox().x0(); x <= output.bbox().x1(); ++x) {
+                Index2 const out_index(x, y);
+                Real2 in_pos = transform(Real2(out_index));
+                IndexBox box(
+                    computeFootprint(in_pos.x(), input.bbox().x()),
+                    computeFootprint(in_pos.y(), input.bbox().y())
+                );
+                if (box.isEmpty()) {
+                    output.image()[out_index] = 0.0f;
+                    output.mask()[out_index] = 0;
+                    output.variance()[out_index] = 0.0f;
+                    continue;
+                }
+                derived().fill(in_pos.x(), box.x(), &kx.coeffRef(0));
+                derived().fill(in_pos.y(), box.y(), &ky.coeffRef(0));
+                w = (ky.head(box.y().size()).matrix()*kx.head(box.x().size()).matrix().transpose()).array();
+                output.image()[out_index] = (input.image().array(box)*w).sum();
+                output.variance()[out_index] = (input.variance().array(box)*w.square()).sum();
+                auto mask = input.mask().array(box);
+                MaskPixel bits = 0;
+                for (Index i = 0; i < w.rows(); ++i) {
+                    for (Index j = 0; j < w.cols(); ++j) {
+                        if (w(i, j) != 0.0f) bits |= mask(i, j);
+                    }
+                }
+                output.mask()[out_index] = bits;
+            }
+        }
+    }
+
+    // Compute warpConvolved for the output pixels in a band.  Each output
+    // pixel's weight for input pixel q is c_q = sum_f w_f W[f - u q], where
+    // w_f are the interpolation weights on the upsampled grid and W is the
+    // stuffed kernel; since w_f = ky[f.y]*kx[f.x], we sum over the x weights
+    // for each kernel row first and then over the y weights.
+    void warpConvolvedBand(
+        Image<float const> const & image,
+        Image<MaskPixel const> const & mask,
+        Image<float const> const & variance,
+        Image<float const> const & weights,
+        Index u,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const {
+        using Buffer = Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+        IndexBox const & kernelBBox = weights.bbox();
+        Index2 const size = kernelBBox.size();
+        Eigen::ArrayXf kx(computeArraySize(image.bbox().width()));
+        Eigen::ArrayXf ky(computeArraySize(image.bbox().height()));
+        Buffer w;
+        Buffer rows(size.y(), (kx.size() + size.x() - 2)/u + 2);
+        Buffer coefficients((ky.size() + size.y() - 2)/u + 2, rows.cols());
+        for (Index y = output.bbox().y0(); y <= output.bbox().y1(); ++y) {
+            for (Index x = output.bbox().x0(); x <= output.bbox().x1(); ++x) {
+                Index2 const out_index(x, y);
+                Real2 const in_pos = transform(Real2(out_index));
+                IndexBox const box(
+                    computeFootprint(in_pos.x(), image.bbox().x()),
+                    computeFootprint(in_pos.y(), image.bbox().y())
+                );
+                // Input pixels whose stuffed kernel overlaps the footprint.
+                IndexBox const qbox = IndexBox::fromMinMax(
+                    Index2(detail::ceilDiv(box.x0() - kernelBBox.x1(), u),
+                           detail::ceilDiv(box.y0() - kernelBBox.y1(), u)),
+                    Index2(detail::floorDiv(box.x1() - kernelBBox.x0(), u),
+                           detail::floorDiv(box.y1() - kernelBBox.y0(), u))
+                ).clippedTo(variance.bbox());
+                if (box.isEmpty()) {
+                    output.image()[out_index] = 0.0f;
+                    output.mask()[out_index] = 0;
+                    output.variance()[out_index] = 0.0f;
+                    continue;
+                }
+                derived().fill(in_pos.x(), box.x(), &kx.coeffRef(0));
+                derived().fill(in_pos.y(), box.y(), &ky.coeffRef(0));
+                w = (ky.head(box.y().size()).matrix()*kx.head(box.x().size()).matrix().transpose()).array();
+                output.image()[out_index] = (image.array(box)*w).sum();
+                auto pixels = mask.array(box);
+                MaskPixel bits = 0;
+                for (Index i = 0; i < w.rows(); ++i) {
+                    for (Index j = 0; j < w.cols(); ++j) {
+                        if (w(i, j) != 0.0f) bits |= pixels(i, j);
+                    }
+                }
+                output.mask()[out_index] = bits;
+                if (qbox.isEmpty()) {
+                    output.variance()[out_index] = 0.0f;
+                    continue;
+                }
+                for (Index n = 0; n < qbox.width(); ++n) {
+                    Index const offset = u*(qbox.x0() + n) + kernelBBox.x0();
+                    IndexInterval const f = IndexInterval::fromMinSize(offset, size.x()).clippedTo(box.x());
+                    auto const k = weights.array().middleCols(f.min() - offset, f.size()).matrix();
+                    rows.col(n).head(size.y()) = k.lazyProduct(kx.segment(f.min() - box.x0(), f.size()).matrix()).array();
+                }
+                for (Index m = 0; m < qbox.height(); ++m) {
+                    Index const offset = u*(qbox.y0() + m) + kernelBBox.y0();
+                    IndexInterval const f = IndexInterval::fromMinSize(offset, size.y()).clippedTo(box.y());
+                    auto const k = ky.segment(f.min() - box.y0(), f.size()).matrix().transpose();
+                    coefficients.row(m).head(qbox.width()) =
+                        k.lazyProduct(rows.block(f.min() - offset, 0, f.size(), qbox.width()).matrix()).array();
+                }
+                output.variance()[out_index] = (
+                    coefficients.topLeftCorner(qbox.height(), qbox.width()).square() *
+                    variance.array(qbox)
+                ).sum();
+            }
+        }
+    }
+
+    // As warpSeparable, propagating variance with the squared weights along
+    // each dimension and OR-ing masks first along rows and then columns.
+    void warpMaskedSeparable(
+        MaskedImage const & input,
+        Affine const & transform,
+        MaskedImage const & output
+    ) const {
+        SeparableWeights wx = computeSeparableWeights(
+            output.bbox().x(), transform.matrix()(0, 0), transform.vector()[0], input.bbox().x()
+        );
+        SeparableWeights wy = computeSeparableWeights(
+            output.bbox().y(), transform.matrix()(1, 1), transform.vector()[1], input.bbox().y()
+        );
+        output.image().array().setZero();
+        output.mask().array().setZero();
+        output.variance().array().setZero();
+        if (wx.hull.isEmpty() || wy.hull.isEmpty()) {
+            return;
+        }
+        MaskedImage tmp(IndexBox(output.bbox().x(), wy.hull), ImageLayout::PADDED);
+        for (Index y = wy.hull.min(); y <= wy.hull.max(); ++y) {
+            for (Index n = 0; n < output.bbox().width(); ++n) {
+                IndexInterval const & footprint = wx.footprints[n];
+                if (footprint.isEmpty()) continue;
+                IndexBox const box(footprint, IndexInterval::fromMinSize(y, 1));
+                Index2 const tmp_index(output.bbox().x0() + n, y);
+                auto weights = wx.values.row(n).head(footprint.size());
+                tmp.image()[tmp_index] = (input.image().array(box).row(0)*weights).sum();
+                tmp.variance()[tmp_index] = (input.variance().array(box).row(0)*weights.square()).sum();
+                auto mask = input.mask().array(box).row(0);
+                MaskPixel bits = 0;
+                for (Index k = 0; k < footprint.size(); ++k) {
+                    if (weights[k] != 0.0f) bits |= mask[k];
+                }
+                tmp.mask()[tmp_index] = bits;
+            }
+        }
+        for (Index n = 0; n < output.bbox().height(); ++n) {
+            IndexInterval const & footprint = wy.footprints[n];
+            auto image_row = output.image().array().row(n);
+            auto mask_row = output.mask().array().row(n);
+            auto variance_row = output.variance().array().row(n);
+            for (Index k = 0; k < footprint.size(); ++k) {
+                Index const r = footprint.min() + k - wy.hull.min();
+                float const weight = wy.values(n, k);
+                image_row += weight*tmp.image().array().row(r);
+                variance_row += weight*weight*tmp.variance().array().row(r);
+                if (weight != 0.0f) {
+                    mask_row = mask_row.binaryExpr(tmp.mask().array().row(r), std::bit_or<MaskPixel>());
+                }
+            }
+        }
+    }
+
+    // As warpSeparable, with the weights along each dimension computed once
+    // for all planes.
+    void warpStackSeparable(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output
+    ) const {
+        SeparableWeights wx = computeSeparableWeights(
+            output.bbox().x(), transform.matrix()(0, 0), transform.vector()[0], input.bbox().x()
+        );
+        SeparableWeights wy = computeSeparableWeights(
+            output.bbox().y(), transform.matrix()(1, 1), transform.vector()[1], input.bbox().y()
+        );
+        for (Index p = 0; p < output.planeCount(); ++p) {
+            output.array(p).setZero();
+        }
+        if (wx.hull.isEmpty() || wy.hull.isEmpty()) {
+            return;
+        }
+        Image<float> tmp(IndexBox(output.bbox().x(), wy.hull), ImageLayout::PADDED);
+        for (Index p = 0; p < input.planeCount(); ++p) {
+            for (Index y = wy.hull.min(); y <= wy.hull.max(); ++y) {
+                float * tmp_pixel = &tmp[Index2(output.bbox().x0(), y)];
+                for (Index n = 0; n < output.bbox().width(); ++n, ++tmp_pixel) {
+                    IndexInterval const & footprint = wx.footprints[n];
+                    if (footprint.isEmpty()) continue;
+                    *tmp_pixel = (
+                        input.array(p, IndexBox(footprint, IndexInterval::fromMinSize(y, 1))).row(0) *
+                        wx.values.row(n).head(footprint.size())
+                    ).sum();
+                }
+            }
+            auto out = output.array(p);
+            for (Index n = 0; n < output.bbox().height(); ++n) {
+                IndexInterval const & footprint = wy.footprints[n];
+                auto out_row = out.row(n);
+                for (Index k = 0; k < footprint.size(); ++k) {
+                    out_row += wy.values(n, k)*tmp.array().row(footprint.min() + k - wy.hull.min());
+                }
+            }
+        }
+    }
+
+    // Interpolation weights for each output index along one dimension of a
+    // separable warp.
+    struct SeparableWeights {
+        std::vector<IndexInterval> footprints;
+        Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> values;
+        IndexInterval hull;
+    };
+
+    // Return the range of input pixels within the interpolant's radius of the
+    // given position, clipped to the given bounds.
+    IndexInterval computeFootprint(Real center, IndexInterval const & bounds) const {
+        return IndexInterval::fromMinMax(
+            static_cast<Index>(std::lround(std::max(center - _radius, static_cast<Real>(bounds.min())))),
+            static_cast<Index>(std::lround(std::min(center + _radius, static_cast<Real>(bounds.max()))))
+        );
+    }
+
+    SeparableWeights computeSeparableWeights(
+        IndexInterval const & output,
+        Real scale,
+        Real offset,
+        IndexInterval const & input
+    ) const {
+        SeparableWeights result;
+        result.footprints.reserve(output.size());
+        result.values.setZero(output.size(), computeArraySize(input.size()));
+        for (Index n = 0; n < output.size(); ++n) {
+            Real center = scale*(output.min() + n) + offset;
+            result.footprints.push_back(computeFootprint(center, input));
+            result.hull.expandTo(result.footprints.back());
+            derived().fill(center, result.footprints.back(), &result.values.coeffRef(n, 0));
+        }
+        return result;
+    }
+
+    // Warp with a transform whose Jacobian is diagonal, as one pass along
+    // rows (into a temporary with one row per input row used) followed by
+    // one pass along columns.
+    template <typename T>
+    void warpSeparable(
+        Image<T const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const {
+        SeparableWeights wx = computeSeparableWeights(
+            output.bbox().x(), transform.matrix()(0, 0), transform.vector()[0], input.bbox().x()
+        );
+        SeparableWeights wy = computeSeparableWeights(
+            output.bbox().y(), transform.matrix()(1, 1), transform.vector()[1], input.bbox().y()
+        );
+        output.array().setZero();
+        if (wx.hull.isEmpty() || wy.hull.isEmpty()) {
+            return;
+        }
+        Image<float> tmp(IndexBox(output.bbox().x(), wy.hull), ImageLayout::PADDED);
+        for (Index y = wy.hull.min(); y <= wy.hull.max(); ++y) {
+            T const * in_row = &input[Index2(input.bbox().x0(), y)];
+            float * tmp_pixel = &tmp[Index2(output.bbox().x0(), y)];
+            for (Index n = 0; n < output.bbox().width(); ++n, ++tmp_pixel) {
+                IndexInterval const & footprint = wx.footprints[n];
+                if (footprint.isEmpty()) continue;
+                *tmp_pixel = (
+                    Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1> const>(
+                        in_row + footprint.min() - input.bbox().x0(), footprint.size()
+                    ).template cast<float>() *
+                    wx.values.row(n).head(footprint.size()).transpose()
+                ).sum();
+            }
+        }
+        for (Index n = 0; n < output.bbox().height(); ++n) {
+            IndexInterval const & footprint = wy.footprints[n];
+            auto out_row = output.array().row(n);
+            for (Index k = 0; k < footprint.size(); ++k) {
+                out_row += wy.values(n, k)*tmp.array().row(footprint.min() + k - wy.hull.min());
+            }
+        }
+    }
+
+    // Accumulate the convolution of the input (zero-stuffed onto a grid
+    // upsampled by u) with the given kernel weights, for just the pixels in
+    // the given output image.
+    template <typename Input>
+    static void convolveStuffed(
+        Input const & input,
+        detail::StuffedWeights const & weights,
+        Index2 const & kernelMin,
+        Index u,
+        Image<float> const & output
+    ) {
+        detail::stuffKernel(
+            input, weights, kernelMin, u, output,
+            [](auto & target, float weight, auto const & source) { target += weight*source.template cast<float>(); }
+        );
+    }
+
     Real _radius;
 };
 
@@ -78,6 +831,8 @@ private:
 class SincInterpolant : public InterpolantImpl<SincInterpolant> {
 public:
 
+    using InterpolantImpl<SincInterpolant>::warp;
+
     SincInterpolant() : InterpolantImpl<SincInterpolant>(std::numeric_limits<float>::infinity()) {}
 
     double evaluate(double x) const {
@@ -85,6 +840,142 @@ public:
         return x == 0.0 ? 1.0 : std::sin(y)/y;
     }
 
+    void warp(
+        Image<float const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const override {
+        warpSinc(input, transform, output);
+    }
+
+    void warp(
+        Image<std::uint16_t const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const override {
+        warpSinc(input, transform, output);
+    }
+
+    void warp(
+        Image<Half const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const override {
+        warpSinc(input, transform, output);
+    }
+
+    // Planes of a stack use the Fourier-space special cases whenever images
+    // would, so warping a stack matches warping each plane separately.
+    void warp(
+        ImageStack<float> const & input,
+        Affine const & transform,
+        ImageStack<float> const & output
+    ) const override {
+        checkStacks(input, output);
+        Index ux = 0, sx = 0, uy = 0, sy = 0;
+        if (!getFourierFactors(input.bbox(), transform, ux, sx, uy, sy)) {
+            warpDirect(input, transform, output);
+            return;
+        }
+        for (Index p = 0; p < input.planeCount(); ++p) {
+            warpFourier(
+                Plane<float const>{input.data() + p*input.planeStride(), input.rowStride(),
+                                   input.pixelStride(), input.bbox()},
+                transform,
+                Plane<float>{output.data() + p*output.planeStride(), output.rowStride(),
+                             output.pixelStride(), output.bbox()},
+                ux, sx, uy, sy
+            );
+        }
+    }
+
+private:
+
+    // Strided view of the pixels of an image or of one plane of a stack.
+    template <typename T>
+    struct Plane {
+        T * data;
+        Index rowStride;
+        Index pixelStride;
+        IndexBox bbox;
+    };
+
+    // Return true if the transform can be applied in Fourier space, setting
+    // the upsampling factor and step along each dimension.
+    static bool getFourierFactors(
+        IndexBox const & input,
+        Affine const & transform,
+        Index & ux, Index & sx,
+        Index & uy, Index & sy
+    ) {
+        return transform.matrix()(0, 1) == 0.0 && transform.matrix()(1, 0) == 0.0 &&
+            FourierAxis::getFactors(transform.matrix()(0, 0), ux, sx) &&
+            FourierAxis::getFactors(transform.matrix()(1, 1), uy, sy) &&
+            !input.isEmpty();
+    }
+
+    // Use the Fourier-space special cases for every pixel type, so converted
+    // inputs give the same results as float ones.
+    template <typename T>
+    void warpSinc(
+        Image<T const> const & input,
+        Affine const & transform,
+        Image<float> const & output
+    ) const {
+        Index ux = 0, sx = 0, uy = 0, sy = 0;
+        if (getFourierFactors(input.bbox(), transform, ux, sx, uy, sy)) {
+            warpFourier(
+                Plane<T const>{input.data(), input.stride(), 1, input.bbox()},
+                transform,
+                Plane<float>{output.data(), output.stride(), 1, output.bbox()},
+                ux, sx, uy, sy
+            );
+        } else {
+            InterpolantImpl<SincInterpolant>::warp(input, transform, output);
+        }
+    }
+
+    // Warp by a translation and integer up- or downsampling in Fourier space,
+    // one dimension at a time.  This treats the input as periodic.
+    template <typename T>
+    void warpFourier(
+        Plane<T const> const & input,
+        Affine const & transform,
+        Plane<float> const & output,
+        Index ux, Index sx,
+        Index uy, Index sy
+    ) const {
+        auto tmp = Image<float>::makeUninitialized(IndexBox(output.bbox.x(), input.bbox.y()),
+                                                   ImageLayout::PADDED);
+        // Each task resamples a band of rows (or columns) with one workspace.
+        FourierAxis const xAxis(input.bbox.x(), output.bbox.x(), ux, sx,
+                                transform.matrix()(0, 0), transform.vector()[0]);
+        FourierAxis const yAxis(input.bbox.y(), output.bbox.y(), uy, sy,
+                                transform.matrix()(1, 1), transform.vector()[1]);
+        Index const height = input.bbox.height();
+        detail::parallelFor(
+            (height + DEFAULT_BAND_HEIGHT - 1)/DEFAULT_BAND_HEIGHT,
+            [&](Index n) {
+                FourierAxis::Workspace ws;
+                for (Index i = n*DEFAULT_BAND_HEIGHT; i < std::min((n + 1)*DEFAULT_BAND_HEIGHT, height); ++i) {
+                    xAxis.apply(input.data + i*input.rowStride, input.pixelStride,
+                                tmp.data() + i*tmp.stride(), 1, ws);
+                }
+            }
+        );
+        Index const width = output.bbox.width();
+        detail::parallelFor(
+            (width + DEFAULT_BAND_HEIGHT - 1)/DEFAULT_BAND_HEIGHT,
+            [&](Index n) {
+                FourierAxis::Workspace ws;
+                for (Index j = n*DEFAULT_BAND_HEIGHT; j < std::min((n + 1)*DEFAULT_BAND_HEIGHT, width); ++j) {
+                    yAxis.apply(tmp.data() + j, tmp.stride(),
+                                output.data + j*output.pixelStride, output.rowStride, ws);
+                }
+            }
+        );
+    }
+
 };
 
 
@@ -92,6 +983,8 @@ public:
 class CubicInterpolant : public InterpolantImpl<CubicInterpolant> {
 public:
 
+    static constexpr Index MAX_FOOTPRINT = 6;
+
     CubicInterpolant() : InterpolantImpl<CubicInterpolant>(2.0) {}
 
     double evaluate(double x) const {
@@ -105,6 +998,16 @@ public:
         return ((1.5*y - 2.5)*y)*y + 1.0;
     }
 
+    // Each polynomial piece vanishes at both ends of its interval, so we can
+    // clamp the argument to each interval and sum the pieces, avoiding
+    // branches the compiler can't vectorize.
+    void evaluateChunk(Chunk & x) const {
+        Chunk y = x.abs();
+        Chunk y0 = y.min(1.0f);
+        Chunk y1 = y.max(1.0f).min(2.0f);
+        x = ((1.5f*y0 - 2.5f)*y0)*y0 + 1.0f - 0.5f*(y1 - 1.0f)*(y1 - 2.0f).square();
+    }
+
 };
 
 
@@ -112,6 +1015,8 @@ public:
 class QuinticInterpolant : public InterpolantImpl<QuinticInterpolant> {
 public:
 
+    static constexpr Index MAX_FOOTPRINT = 8;
+
     QuinticInterpolant() : InterpolantImpl<QuinticInterpolant>(3.0) {}
 
     double evaluate(double x) const {
@@ -128,6 +1033,154 @@ public:
         return ((-55.0*y + 138.0)*y - 95.0)*y*y*y/12.0 + 1.0;
     }
 
+    // See CubicInterpolant::evaluateChunk.
+    void evaluateChunk(Chunk & x) const {
+        Chunk y = x.abs();
+        Chunk y0 = y.min(1.0f);
+        Chunk y1 = y.max(1.0f).min(2.0f);
+        Chunk y2 = y.max(2.0f).min(3.0f);
+        x = ((-55.0f*y0 + 138.0f)*y0 - 95.0f)*y0.cube()/12.0f + 1.0f
+            + (y1 - 1.0f)*(y1 - 2.0f)*(((55.0f*y1 - 249.0f)*y1 + 348.0f)*y1 - 138.0f)/24.0f
+            + (y2 - 2.0f)*(y2 - 3.0f).square()*((-11.0f*y2 + 50.0f)*y2 - 54.0f)/24.0f;
+    }
+
+};
+
+
+// Lanczos interpolant of the given order: sinc(x)sinc(x/N) for |x| < N.
+template <int N>
+class LanczosInterpolant : public InterpolantImpl<LanczosInterpolant<N>> {
+public:
+
+    static constexpr Index MAX_FOOTPRINT = 2*N + 2;
+
+    LanczosInterpolant() : InterpolantImpl<LanczosInterpolant<N>>(N) {
+        for (Index k = 0; k < MAX_FOOTPRINT; ++k) {
+            _cos[k] = std::cos(k*M_PI/N);
+            _sin[k] = std::sin(k*M_PI/N);
+        }
+    }
+
+    double evaluate(double x) const {
+        double y = std::fabs(x);
+        if (y >= N) {
+            return 0.0;
+        }
+        if (y < 1E-8) {
+            return 1.0;
+        }
+        return N*std::sin(M_PI*y)*std::sin(M_PI*y/N)/(M_PI*M_PI*y*y);
+    }
+
+    // The footprint's positions differ by whole pixels, so one evaluation of
+    // sin(pi x) and sin(pi x/N) (stepped with precomputed rotations) gives
+    // every weight.
+    void fill(float x, IndexInterval const & interval, float * output) const {
+        assert(interval.size() <= MAX_FOOTPRINT);
+        double const d0 = x - interval.min();
+        double const s0 = std::sin(M_PI*d0);
+        double const st = std::sin(M_PI*d0/N);
+        double const ct = std::cos(M_PI*d0/N);
+        double sign = 1.0;
+        for (Index k = 0; k < MAX_FOOTPRINT && k < interval.size(); ++k, sign = -sign) {
+            double d = d0 - k;
+            if (std::fabs(d) >= N) {
+                output[k] = 0.0f;
+            } else if (std::fabs(d) < 1E-8) {
+                output[k] = 1.0f;
+            } else {
+                output[k] = N*sign*s0*(st*_cos[k] - ct*_sin[k])/(M_PI*M_PI*d*d);
+            }
+        }
+    }
+
+private:
+    double _cos[MAX_FOOTPRINT];
+    double _sin[MAX_FOOTPRINT];
+};
+
+
+// Interpolant that looks up the weights of another interpolant in a table
+// evaluated at a fixed number of fractional phases per pixel.
+class TabulatedInterpolant : public InterpolantImpl<TabulatedInterpolant> {
+public:
+
+    TabulatedInterpolant(std::shared_ptr<Interpolant const> exact, Index phases, bool blend) :
+        InterpolantImpl<TabulatedInterpolant>(exact->radius()),
+        _phases(phases),
+        _blend(blend),
+        _offset(computeOffset(*exact, phases)),
+        _table(phases + 1, 2*_offset + 1),
+        _maxError(0.0)
+    {
+        // Row p holds the weights for an input position p/phases past an
+        // integer, for pixels from _offset before that integer to _offset
+        // after it.
+        for (Index p = 0; p <= _phases; ++p) {
+            for (Index j = 0; j < _table.cols(); ++j) {
+                _table(p, j) = (*exact)(Real(p)/_phases + _offset - j);
+            }
+        }
+        // Measure the worst-case error on a grid several times finer than
+        // the table, which includes the points halfway between phases.
+        Index const oversampling = 8;
+        for (Index n = -_offset*_phases*oversampling; n <= _offset*_phases*oversampling; ++n) {
+            double x = double(n)/(_phases*oversampling);
+            _maxError = std::max(_maxError, std::fabs(evaluate(x) - (*exact)(x)));
+        }
+    }
+
+    double maxError() const override { return _maxError; }
+
+    double evaluate(double x) const {
+        float result = 0.0f;
+        Index i = 0;
+        fill(x, IndexInterval::fromMinMax(i, i), &result);
+        return result;
+    }
+
+    void fill(float x, IndexInterval const & interval, float * output) const {
+        float const base = std::floor(x);
+        float const phase = (x - base)*_phases;
+        Index const j0 = interval.min() - static_cast<Index>(base) + _offset;
+        Eigen::Map<Array> out(output, interval.size());
+        IndexInterval columns = IndexInterval::fromMinSize(j0, interval.size());
+        columns.clipTo(IndexInterval::fromMinSize(0, _table.cols()));
+        if (columns.size() != interval.size()) {
+            // Pixels beyond the tabulated ones are outside the radius.
+            out.setZero();
+        }
+        if (columns.isEmpty()) {
+            return;
+        }
+        auto target = out.segment(columns.min() - j0, columns.size());
+        if (_blend) {
+            Index p = std::min(static_cast<Index>(phase), _phases - 1);
+            float t = phase - p;
+            target = (1.0f - t)*_table.row(p).segment(columns.min(), columns.size()).transpose()
+                + t*_table.row(p + 1).segment(columns.min(), columns.size()).transpose();
+        } else {
+            target = _table.row(std::lround(phase)).segment(columns.min(), columns.size()).transpose();
+        }
+    }
+
+private:
+
+    static Index computeOffset(Interpolant const & exact, Index phases) {
+        if (!std::isfinite(exact.radius())) {
+            throw std::invalid_argument("Cannot tabulate an interpolant with infinite radius.");
+        }
+        if (phases < 1) {
+            throw std::invalid_argument("Number of phases must be positive.");
+        }
+        return static_cast<Index>(std::ceil(exact.radius())) + 1;
+    }
+
+    Index _phases;
+    bool _blend;
+    Index _offset;
+    Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> _table;
+    double _maxError;
 };
 
 } // anonymous
@@ -152,4 +1205,27 @@ std::shared_ptr<Interpolant const> Interpolant::quintic() {
     return instance;
 }
 
+std::shared_ptr<Interpolant const> Interpolant::lanczos(Index order) {
+    static std::shared_ptr<LanczosInterpolant<3> const> instance3 = std::make_shared<LanczosInterpolant<3>>();
+    static std::shared_ptr<LanczosInterpolant<4> const> instance4 = std::make_shared<LanczosInterpolant<4>>();
+    static std::shared_ptr<LanczosInterpolant<5> const> instance5 = std::make_shared<LanczosInterpolant<5>>();
+    switch (order) {
+    case 3:
+        return instance3;
+    case 4:
+        return instance4;
+    case 5:
+        return instance5;
+    }
+    throw std::invalid_argument("Lanczos order must be 3, 4, or 5.");
+}
+
+std::shared_ptr<Interpolant const> Interpolant::tabulate(
+    std::shared_ptr<Interpolant const> exact,
+    Index phases,
+    bool blend
+) {
+    return std::make_shared<TabulatedInterpolant>(std::move(exact), phases, blend);
+}
+
 } // namespace cipells
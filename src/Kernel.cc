@@ -1,13 +1,32 @@
 #define CIPELLS_Kernel_cc_SRC
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "Eigen/SVD"
 
 #include "cipells/Kernel.h"
+#include "cipells/parallel.h"
+#include "impl/fft.h"
+#include "impl/upsampling.h"
 
 namespace cipells {
 
 namespace {
 
+// Minimum size (in output pixels) of the tiles Kernel convolves at once in
+// FFT and SEPARABLE modes.  This is larger than InterpolantImpl's tiles, so
+// the FFT blocks (or separable passes) of adjacent tiles overlap less, but
+// still bounds the size of each tile's upsampled intermediate image.
+constexpr Index KERNEL_TILE_SIZE = 128;
+
+using StridedArray = Eigen::Map<Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+                                Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
 void checkKernelDimensions(IndexBox const & bbox) {
     if (bbox.width() % 2 != 1 || bbox.height() % 2 != 1) {
         throw std::invalid_argument("Kernel width and height must be odd.");
@@ -17,8 +36,112 @@ void checkKernelDimensions(IndexBox const & bbox) {
     }
 }
 
+// Return the size of the FFT blocks used to convolve with a kernel
+// component of the given size, which keeps the overlap between blocks to at
+// most a quarter of each block.
+Index computeBlockSize(Index taps) {
+    Index result = 32;
+    while (result < 4*taps) {
+        result *= 2;
+    }
+    return result;
+}
+
 } // anonymous
 
+// Transforms of the kernel's polyphase components, shared by copies of a
+// Kernel and computed the first time each is needed.
+//
+// Convolving a zero-stuffed input with the kernel on its upsampled grid
+// yields, at fine pixel u*m + p (for phase 0 <= p < u in each dimension),
+// the ordinary convolution of the input with the kernel pixels u*t + p,
+// evaluated at m.  There is one such component for each of the u^2 phases.
+struct Kernel::Spectra {
+
+    Spectra(IndexBox const & bbox, Index upsampling) :
+        taps(
+            IndexInterval::fromMinMax(detail::floorDiv(bbox.x0(), upsampling),
+                                      detail::floorDiv(bbox.x1(), upsampling)),
+            IndexInterval::fromMinMax(detail::floorDiv(bbox.y0(), upsampling),
+                                      detail::floorDiv(bbox.y1(), upsampling))
+        ),
+        blockSize(computeBlockSize(taps.width()), computeBlockSize(taps.height()))
+    {}
+
+    // Return the transforms of the components of the given kernel image
+    // (flipped if transpose is true), indexed by py*upsampling + px.
+    std::vector<Image<std::complex<float>>> const & get(
+        Image<float const> const & image,
+        Index upsampling,
+        bool transpose
+    ) {
+        std::call_once(
+            once[transpose],
+            [&]() {
+                // The transforms are unnormalized, so we fold the inverse
+                // transform's normalization into the kernel, along with the
+                // u^2 that preserves flux (see InterpolantImpl::convolve).
+                float const scale = float(upsampling*upsampling)/(blockSize.x()*blockSize.y());
+                IndexBox const blockBox = IndexBox::fromMinSize(Index2(0, 0), blockSize);
+                for (Index py = 0; py < upsampling; ++py) {
+                    for (Index px = 0; px < upsampling; ++px) {
+                        Image<std::complex<float>> phase(blockBox);
+                        for (Index ty = taps.y0(); ty <= taps.y1(); ++ty) {
+                            for (Index tx = taps.x0(); tx <= taps.x1(); ++tx) {
+                                Index2 j(upsampling*tx + px, upsampling*ty + py);
+                                if (transpose) {
+                                    j = -j;
+                                }
+                                if (image.bbox().contains(j)) {
+                                    phase[Index2(tx, ty) - taps.min()] = scale*image[j];
+                                }
+                            }
+                        }
+                        detail::transform2d(phase, false);
+                        phases[transpose].push_back(std::move(phase));
+                    }
+                }
+            }
+        );
+        return phases[transpose];
+    }
+
+    // Return the size of the output tiles whose regions (for transforms
+    // that do not change the scale much) are covered by a whole number of
+    // blocks' valid pixels, which are computed whether they are needed or
+    // not.  The coarse pixels of a tile's region are the tile's own plus
+    // those that the interpolant's footprint adds at its edges (interpolants
+    // with infinite radius are processed as a single tile anyway).
+    Index2 computeTileSize(Index upsampling, Real radius) const {
+        Index2 const valid = blockSize - taps.size() + Index2(1, 1);
+        Index const margin = std::isfinite(radius) ?
+            static_cast<Index>(std::ceil((2*radius + 3)/upsampling)) + 1 : 0;
+        Index2 result;
+        for (int d = 0; d < 2; ++d) {
+            Index k = 1;
+            while (k*valid[d] - margin < KERNEL_TILE_SIZE) {
+                ++k;
+            }
+            result[d] = k*valid[d] - margin;
+        }
+        return result;
+    }
+
+    IndexBox taps;
+    Index2 blockSize;
+    std::once_flag once[2];
+    std::vector<Image<std::complex<float>>> phases[2];
+};
+
+// Separable terms of a kernel image: the image is the sum over terms i of
+// the outer product of columns.col(i) (over rows) and rows.col(i) (over
+// columns).
+struct Kernel::Decomposition {
+    Eigen::ArrayXXf columns;
+    Eigen::ArrayXXf rows;
+    Real residual;
+};
+
 Kernel::Kernel(Image<float const> && image, Index upsampling,
                std::shared_ptr<Interpolant const> interpolant) :
     _image(std::move(image).freeze()),
@@ -26,6 +149,7 @@ Kernel::Kernel(Image<float const> && image, Index upsampling,
     _interpolant(interpolant ? std::move(interpolant) : Interpolant::default_())
 {
     checkKernelDimensions(_image.bbox());
+    _spectra = std::make_shared<Spectra>(_image.bbox(), _upsampling);
 }
 
 Kernel::Kernel(Image<float const> const & image, Index upsampling,
@@ -35,6 +159,7 @@ Kernel::Kernel(Image<float const> const & image, Index upsampling,
     _interpolant(interpolant ? std::move(interpolant) : Interpolant::default_())
 {
     checkKernelDimensions(_image.bbox());
+    _spectra = std::make_shared<Spectra>(_image.bbox(), _upsampling);
 }
 
 Kernel Kernel::resample(Index upsampling, std::shared_ptr<Interpolant const> interpolant) const {
@@ -66,33 +191,463 @@ Kernel Kernel::warp(Affine const & transform, IndexBox const & bbox, Index upsam
     return Kernel(std::move(output), upsampling, std::move(interpolant));
 }
 
+Kernel Kernel::decompose(Real tolerance) const {
+    if (!(tolerance >= 0.0)) {
+        throw std::invalid_argument("Decomposition tolerance must be nonnegative.");
+    }
+    Eigen::MatrixXd matrix = _image.array().cast<double>().matrix();
+    Eigen::JacobiSVD<Eigen::MatrixXd> svd(matrix, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    Eigen::VectorXd const & sigma = svd.singularValues();
+    // The squared Frobenius norm of the residual of a rank-k truncation is
+    // the sum of the squares of the discarded singular values.
+    Real const total = sigma.squaredNorm();
+    Real remaining = total;
+    Index rank = 0;
+    while (rank < sigma.size() && remaining > tolerance*tolerance*total) {
+        remaining -= sigma[rank]*sigma[rank];
+        ++rank;
+    }
+    auto decomposition = std::make_shared<Decomposition>();
+    decomposition->columns = (svd.matrixU().leftCols(rank)*sigma.head(rank).asDiagonal()).cast<float>().array();
+    decomposition->rows = svd.matrixV().leftCols(rank).cast<float>().array();
+    auto image = Image<float>::makeUninitialized(_image.bbox());
+    image.array() = (
+        decomposition->columns.matrix()*decomposition->rows.matrix().transpose()
+    ).array();
+    decomposition->residual = total > 0.0 ?
+        std::sqrt((image.array().cast<double>() - _image.array().cast<double>()).square().sum()/total) :
+        0.0;
+    Kernel result(std::move(image), _upsampling, _interpolant);
+    result._decomposition = std::move(decomposition);
+    return result;
+}
+
+Index Kernel::separableRank() const {
+    return _decomposition ? _decomposition->columns.cols() : 0;
+}
+
+Real Kernel::separableResidual() const {
+    return _decomposition ? _decomposition->residual : 0.0;
+}
+
 void Kernel::convolve(
     Image<float const> const & input,
     Affine const & transform,
-    Image<float> const & output
+    Image<float> const & output,
+    ConvolutionMode mode
 ) const {
-    _interpolant->convolve(input, _image, _upsampling, transform, output, false);
+    _convolve(input, transform, output, mode, false);
 }
 
-Image<float> Kernel::convolve(Image<float const> const & input, Affine const & transform) const {
+Image<float> Kernel::convolve(Image<float const> const & input, Affine const & transform,
+                              ConvolutionMode mode) const {
     Image<float> output(IndexBox(transform(RealBox(input.bbox()))));
-    convolve(input, transform, output);
+    convolve(input, transform, output, mode);
     return output;
 }
 
 void Kernel::correlate(
     Image<float const> const & input,
     Affine const & transform,
-    Image<float> const & output
+    Image<float> const & output,
+    ConvolutionMode mode
 ) const {
-    _interpolant->convolve(input, _image, _upsampling, transform, output, true);
+    _convolve(input, transform, output, mode, true);
 }
 
-Image<float> Kernel::correlate(Image<float const> const & input, Affine const & transform) const {
+Image<float> Kernel::correlate(Image<float const> const & input, Affine const & transform,
+                               ConvolutionMode mode) const {
     Image<float> output(IndexBox(transform(RealBox(input.bbox()))));
-    correlate(input, transform, output);
+    correlate(input, transform, output, mode);
     return output;
 }
 
+void Kernel::convolve(
+    Image<std::uint16_t const> const & input,
+    Affine const & transform,
+    Image<float> const & output,
+    ConvolutionMode mode
+) const {
+    _convolve(input, transform, output, mode, false);
+}
+
+void Kernel::convolve(
+    Image<Half const> const & input,
+    Affine const & transform,
+    Image<float> const & output,
+    ConvolutionMode mode
+) const {
+    _convolve(input, transform, output, mode, false);
+}
+
+void Kernel::correlate(
+    Image<std::uint16_t const> const & input,
+    Affine const & transform,
+    Image<float> const & output,
+    ConvolutionMode mode
+) const {
+    _convolve(input, transform, output, mode, true);
+}
+
+void Kernel::correlate(
+    Image<Half const> const & input,
+    Affine const & transform,
+    Image<float> const & output,
+    ConvolutionMode mode
+) const {
+    _convolve(input, transform, output, mode, true);
+}
+
+void Kernel::convolve(
+    ImageStack<float> const & input,
+    Affine const & transform,
+    ImageStack<float> const & output,
+    ConvolutionMode mode
+) const {
+    _convolveStack(input, transform, output, mode, false);
+}
+
+void Kernel::correlate(
+    ImageStack<float> const & input,
+    Affine const & transform,
+    ImageStack<float> const & output,
+    ConvolutionMode mode
+) const {
+    _convolveStack(input, transform, output, mode, true);
+}
+
+void Kernel::convolve(
+    MaskedImage const & input,
+    Affine const & transform,
+    MaskedImage const & output,
+    ConvolutionMode mode
+) const {
+    _convolveMasked(input, transform, output, mode, false);
+}
+
+void Kernel::correlate(
+    MaskedImage const & input,
+    Affine const & transform,
+    MaskedImage const & output,
+    ConvolutionMode mode
+) const {
+    _convolveMasked(input, transform, output, mode, true);
+}
+
+Kernel::ConvolutionMode Kernel::chooseConvolutionMode() const {
+    // Direct convolution costs a multiply-add per kernel pixel for each
+    // input pixel.  Per input pixel, each FFT block costs one forward and u^2
+    // inverse transforms (roughly 5 N log2 N flops each, for N pixels)
+    // spread over its non-overlapping pixels.  Each separable term costs a
+    // multiply-add per kernel column for each input pixel, and one per
+    // kernel row for each of the u pixels the first pass yields.
+    Index const u = _upsampling;
+    Index2 const n = _spectra->blockSize;
+    Index2 const valid = n - _spectra->taps.size() + Index2(1, 1);
+    Real const area = Real(n.x())*n.y();
+    Real const fftCost = 2.5*(1 + u*u)*area*std::log2(area)/(Real(valid.x())*valid.y());
+    Real const directCost = _image.bbox().area();
+    ConvolutionMode result = fftCost < directCost ? ConvolutionMode::FFT : ConvolutionMode::DIRECT;
+    if (_decomposition) {
+        Real const separableCost = separableRank()*Real(_image.bbox().width() + u*_image.bbox().height());
+        if (separableCost < std::min(fftCost, directCost)) {
+            result = ConvolutionMode::SEPARABLE;
+        }
+    }
+    return result;
+}
+
+template <typename T>
+void Kernel::_convolve(
+    Image<T const> const & input,
+    Affine const & transform,
+    Image<float> const & output,
+    ConvolutionMode mode,
+    bool transpose
+) const {
+    if (mode == ConvolutionMode::AUTO) {
+        mode = chooseConvolutionMode();
+    }
+    if (mode == ConvolutionMode::SEPARABLE && !_decomposition) {
+        throw std::invalid_argument("Kernel has no separable decomposition.");
+    }
+    if (mode == ConvolutionMode::DIRECT) {
+        _interpolant->convolve(input, _image, _upsampling, transform, output, transpose);
+        return;
+    }
+    // As in InterpolantImpl::convolve, we convolve on the upsampled grid and
+    // then warp the result onto the output grid with the interpolant, one
+    // output tile at a time.  The warp never uses the interpolant's
+    // Fourier-space special cases, which would treat the upsampled image as
+    // periodic (unlike DIRECT mode).
+    Index const u = _upsampling;
+    Affine const fine = transform.inverted().then(Jacobian::makeScaling(u));
+    IndexBox const bounds = detail::computeStuffedBBox(input.bbox(), _image.bbox(), u);
+    Index2 const tileSize = mode == ConvolutionMode::FFT ?
+        _spectra->computeTileSize(u, _interpolant->radius()) :
+        Index2(KERNEL_TILE_SIZE, KERNEL_TILE_SIZE);
+    detail::forEachStuffedTile(
+        output.bbox(), bounds, fine, _interpolant->radius(), tileSize,
+        [&](IndexBox const & tile, IndexBox const & region) {
+            if (region.isEmpty()) {
+                output.array(tile).setZero();
+                return;
+            }
+            Image<float> stuffed(region, ImageLayout::PADDED);
+            if (mode == ConvolutionMode::FFT) {
+                _stuffFFT(input, stuffed, transpose);
+            } else {
+                _stuffSeparable(input, stuffed, transpose);
+            }
+            _interpolant->warpDirect(stuffed, fine, output[tile]);
+        }
+    );
+}
+
+// As _convolve, but in each tile every plane is convolved onto the
+// upsampled grid separately (which needs no interpolation weights) and the
+// upsampled stack is then warped onto the tile all at once.
+void Kernel::_convolveStack(
+    ImageStack<float> const & input,
+    Affine const & transform,
+    ImageStack<float> const & output,
+    ConvolutionMode mode,
+    bool transpose
+) const {
+    if (input.planeCount() != output.planeCount()) {
+        throw std::invalid_argument("Input and output image stacks must have the same number of planes.");
+    }
+    if (mode == ConvolutionMode::AUTO) {
+        mode = chooseConvolutionMode();
+    }
+    if (mode == ConvolutionMode::SEPARABLE && !_decomposition) {
+        throw std::invalid_argument("Kernel has no separable decomposition.");
+    }
+    if (mode == ConvolutionMode::DIRECT) {
+        _interpolant->convolve(input, _image, _upsampling, transform, output, transpose);
+        return;
+    }
+    Index const u = _upsampling;
+    Affine const fine = transform.inverted().then(Jacobian::makeScaling(u));
+    IndexBox const & k = _image.bbox();
+    IndexBox const bounds = detail::computeStuffedBBox(input.bbox(), k, u);
+    Index2 const tileSize = mode == ConvolutionMode::FFT ?
+        _spectra->computeTileSize(u, _interpolant->radius()) :
+        Index2(KERNEL_TILE_SIZE, KERNEL_TILE_SIZE);
+    detail::forEachStuffedTile(
+        output.bbox(), bounds, fine, _interpolant->radius(), tileSize,
+        [&](IndexBox const & tile, IndexBox const & region) {
+            ImageStack<float> const target = output[tile];
+            if (region.isEmpty()) {
+                for (Index p = 0; p < target.planeCount(); ++p) {
+                    target.array(p).setZero();
+                }
+                return;
+            }
+            ImageStack<float> stuffed(region, input.planeCount());
+            // Only the input pixels that land on the region are read, and
+            // only those are copied from the planes of interleaved stacks, so
+            // the FFT and separable passes can read them as ordinary images.
+            IndexBox const inputBox = IndexBox::fromMinMax(
+                Index2(detail::ceilDiv(region.x0() - k.x1(), u), detail::ceilDiv(region.y0() - k.y1(), u)),
+                Index2(detail::floorDiv(region.x1() - k.x0(), u), detail::floorDiv(region.y1() - k.y0(), u))
+            ).clippedTo(input.bbox());
+            if (!inputBox.isEmpty()) {
+                ImageStack<float> const pixels = input[inputBox];
+                for (Index p = 0; p < input.planeCount(); ++p) {
+                    Image<float const> plane = input.layout() == StackLayout::PLANAR ?
+                        pixels[p] : pixels.copyPlane(p);
+                    if (mode == ConvolutionMode::FFT) {
+                        _stuffFFT(plane, stuffed[p], transpose);
+                    } else {
+                        _stuffSeparable(plane, stuffed[p], transpose);
+                    }
+                }
+            }
+            _interpolant->warpDirect(stuffed, fine, target);
+        }
+    );
+}
+
+// As _convolve, with the mask plane stuffed directly (and the image plane
+// too, in DIRECT mode) before the interpolant warps both onto each tile.
+// Stuffing the variance with squared kernel values and warping it with
+// squared interpolation weights would drop the cross terms between the two,
+// so the interpolant instead computes it from each input pixel's total
+// weight, with the same interpolation weights (see
+// Interpolant::warpConvolved).
+void Kernel::_convolveMasked(
+    MaskedImage const & input,
+    Affine const & transform,
+    MaskedImage const & output,
+    ConvolutionMode mode,
+    bool transpose
+) const {
+    if (mode == ConvolutionMode::AUTO) {
+        mode = chooseConvolutionMode();
+    }
+    if (mode == ConvolutionMode::SEPARABLE && !_decomposition) {
+        throw std::invalid_argument("Kernel has no separable decomposition.");
+    }
+    Index const u = _upsampling;
+    Affine const fine = transform.inverted().then(Jacobian::makeScaling(u));
+    IndexBox const bounds = detail::computeStuffedBBox(input.bbox(), _image.bbox(), u);
+    Image<float> weights(_image.bbox());
+    weights.array() = detail::computeStuffedWeights(_image, u, transpose);
+    Index2 const tileSize = mode == ConvolutionMode::FFT ?
+        _spectra->computeTileSize(u, _interpolant->radius()) :
+        Index2(KERNEL_TILE_SIZE, KERNEL_TILE_SIZE);
+    detail::forEachStuffedTile(
+        output.bbox(), bounds, fine, _interpolant->radius(), tileSize,
+        [&](IndexBox const & tile, IndexBox const & region) {
+            MaskedImage const out = output[tile];
+            if (region.isEmpty()) {
+                out.image().array().setZero();
+                out.mask().array().setZero();
+                out.variance().array().setZero();
+                return;
+            }
+            Image<float> image(region, ImageLayout::PADDED);
+            Image<MaskPixel> mask(region, ImageLayout::PADDED);
+            if (mode == ConvolutionMode::FFT) {
+                _stuffFFT(Image<float const>(input.image()), image, transpose);
+            } else if (mode == ConvolutionMode::SEPARABLE) {
+                _stuffSeparable(Image<float const>(input.image()), image, transpose);
+            } else {
+                detail::stuffKernel(
+                    input.image(), weights.array(), _image.bbox().min(), u, image,
+                    [](auto & target, float weight, auto const & source) { target += weight*source; }
+                );
+            }
+            detail::stuffKernel(
+                input.mask(), weights.array(), _image.bbox().min(), u, mask,
+                [](auto & target, float weight, auto const & source) {
+                    if (weight != 0.0f) {
+                        target = target.binaryExpr(source, std::bit_or<MaskPixel>());
+                    }
+                }
+            );
+            _interpolant->warpConvolved(image, mask, input.variance(), weights, u, fine, out);
+        }
+    );
+}
+
+// Compute the convolution of the zero-stuffed input with the kernel, one
+// overlap-save block of coarse pixels at a time.
+template <typename T>
+void Kernel::_stuffFFT(Image<T const> const & input, Image<float> const & stuffed, bool transpose) const {
+    Index const u = _upsampling;
+    IndexBox const & region = stuffed.bbox();
+    auto const & phases = _spectra->get(_image, u, transpose);
+    IndexBox const & taps = _spectra->taps;
+    Index2 const blockSize = _spectra->blockSize;
+    Index2 const valid = blockSize - taps.size() + Index2(1, 1);
+    IndexBox const coarse = IndexBox::fromMinMax(
+        Index2(detail::floorDiv(region.x0(), u), detail::floorDiv(region.y0(), u)),
+        Index2(detail::floorDiv(region.x1(), u), detail::floorDiv(region.y1(), u))
+    );
+    Index const nx = (coarse.width() + valid.x() - 1)/valid.x();
+    Index const ny = (coarse.height() + valid.y() - 1)/valid.y();
+    auto func = [&](Index n) {
+        // Block output pixel m needs input pixels m - taps.max() through
+        // m - taps.min(); the first taps.size() - 1 pixels of the circular
+        // convolution wrap around, and the rest are exact.
+        Index2 const m0 = coarse.min() + Index2((n % nx)*valid.x(), (n / nx)*valid.y());
+        Index2 const q0 = m0 - taps.max();
+        IndexBox const blockBox = IndexBox::fromMinSize(Index2(0, 0), blockSize);
+        IndexBox const inBox = IndexBox::fromMinSize(q0, blockSize).clippedTo(input.bbox());
+        if (inBox.isEmpty()) {
+            return;
+        }
+        Image<std::complex<float>> block(blockBox);
+        block.array(inBox.shiftedBy(-q0)) =
+            input.array(inBox).template cast<float>().template cast<std::complex<float>>();
+        detail::transform2d(block, false);
+        auto product = Image<std::complex<float>>::makeUninitialized(blockBox);
+        for (Index py = 0; py < u; ++py) {
+            IndexInterval my = detail::computeStuffedRange(region.y(), py, u)
+                .clipTo(IndexInterval::fromMinSize(m0.y(), valid.y()));
+            for (Index px = 0; px < u; ++px) {
+                IndexInterval mx = detail::computeStuffedRange(region.x(), px, u)
+                    .clipTo(IndexInterval::fromMinSize(m0.x(), valid.x()));
+                if (mx.isEmpty() || my.isEmpty()) continue;
+                product.array() = block.array()*phases[py*u + px].array();
+                detail::transform2d(product, true);
+                StridedArray target(
+                    &stuffed[Index2(u*mx.min() + px, u*my.min() + py)],
+                    my.size(), mx.size(),
+                    Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(u*stuffed.stride(), u)
+                );
+                target = product.array().block(
+                    my.min() - q0.y() - taps.y0(), mx.min() - q0.x() - taps.x0(), my.size(), mx.size()
+                ).real();
+            }
+        }
+    };
+    detail::parallelFor(nx*ny, func);
+}
+
+// Accumulate the convolution of the zero-stuffed input with each separable
+// term of the kernel, as a pass along rows (upsampling only in x) into a
+// temporary with one row per input row, followed by a pass along columns.
+template <typename T>
+void Kernel::_stuffSeparable(Image<T const> const & input, Image<float> const & stuffed,
+                             bool transpose) const {
+    Index const u = _upsampling;
+    IndexBox const & region = stuffed.bbox();
+    IndexBox const & k = _image.bbox();
+    IndexInterval const rows = IndexInterval::fromMinMax(
+        detail::ceilDiv(region.y0() - k.y1(), u),
+        detail::floorDiv(region.y1() - k.y0(), u)
+    ).clipTo(input.bbox().y());
+    if (rows.isEmpty()) {
+        return;
+    }
+    Image<float> tmp(IndexBox(region.x(), rows), ImageLayout::PADDED);
+    for (Index r = 0; r < separableRank(); ++r) {
+        // Each pass scales by u, which together preserve flux as in
+        // InterpolantImpl::convolve.  Correlation flips both 1-D kernels.
+        Eigen::ArrayXf wx = _decomposition->rows.col(r)*u;
+        Eigen::ArrayXf wy = _decomposition->columns.col(r)*u;
+        if (transpose) {
+            wx.reverseInPlace();
+            wy.reverseInPlace();
+        }
+        forEachRowBand(
+            tmp.bbox(),
+            [&](IndexBox const & band) {
+                tmp.array(band).setZero();
+                for (Index i = 0; i < k.width(); ++i) {
+                    Index const jx = k.x0() + i;
+                    IndexInterval qx = detail::computeStuffedRange(region.x(), jx, u).clipTo(input.bbox().x());
+                    if (qx.isEmpty()) continue;
+                    StridedArray target(
+                        &tmp[Index2(u*qx.min() + jx, band.y0())],
+                        band.height(), qx.size(),
+                        Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(tmp.stride(), u)
+                    );
+                    target += wx[i]*input.array(IndexBox(qx, band.y())).template cast<float>();
+                }
+            }
+        );
+        forEachRowBand(
+            region,
+            [&](IndexBox const & band) {
+                for (Index i = 0; i < k.height(); ++i) {
+                    Index const jy = k.y0() + i;
+                    IndexInterval qy = detail::computeStuffedRange(band.y(), jy, u).clipTo(rows);
+                    if (qy.isEmpty()) continue;
+                    StridedArray target(
+                        &stuffed[Index2(region.x0(), u*qy.min() + jy)],
+                        qy.size(), region.width(),
+                        Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(u*stuffed.stride(), 1)
+                    );
+                    target += wy[i]*tmp.array(IndexBox(region.x(), qy));
+                }
+            }
+        );
+    }
+}
+
 
 } // namespace cipells
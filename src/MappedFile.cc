@@ -0,0 +1,262 @@
+#define CIPELLS_MappedFile_cc_SRC
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cipells/MappedFile.h"
+#include "impl/files.h"
+
+namespace cipells {
+
+namespace {
+
+char const IMAGE_FILE_MAGIC[8] = {'C', 'I', 'P', 'E', 'L', 'L', 'S', '1'};
+
+struct ImageFileHeader {
+    char magic[8];
+    std::int32_t pixelType;
+    std::int32_t x0;
+    std::int32_t y0;
+    std::int32_t width;
+    std::int32_t height;
+    std::int32_t stride;
+};
+
+static_assert(sizeof(ImageFileHeader) <= IMAGE_FILE_HEADER_SIZE, "Image file header too large.");
+
+ImageFileHeader readHeader(MappedFile const & file, std::string const & path) {
+    if (file.size() < IMAGE_FILE_HEADER_SIZE) {
+        throw std::runtime_error("File '" + path + "' is too small to be an image file.");
+    }
+    ImageFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, IMAGE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("File '" + path + "' is not an image file.");
+    }
+    return header;
+}
+
+template <typename T>
+IndexBox readImageBox(MappedFile const & file, std::string const & path, Index & stride) {
+    ImageFileHeader header = readHeader(file, path);
+    if (header.pixelType != static_cast<std::int32_t>(detail::PixelTypeOf<T>::value)) {
+        throw std::runtime_error("Image file '" + path + "' has the wrong pixel type.");
+    }
+    stride = header.stride;
+    return IndexBox::fromMinSize(Index2(header.x0, header.y0), Index2(header.width, header.height));
+}
+
+} // anonymous
+
+
+struct MappedFile::Mapping {
+
+    Mapping(void * base_, std::size_t size_, bool writable_) :
+        base(base_), size(size_), writable(writable_)
+    {}
+
+    Mapping(Mapping const &) = delete;
+    Mapping & operator=(Mapping const &) = delete;
+
+    ~Mapping() {
+        if (base) {
+            ::munmap(base, size);
+        }
+    }
+
+    void * base;
+    std::size_t size;
+    bool writable;
+};
+
+
+namespace {
+
+// Map the whole of an open file descriptor, closing it when done.
+void * mapDescriptor(int fd, std::size_t size, bool writable, std::string const & path) {
+    void * base = nullptr;
+    if (size > 0) {
+        base = ::mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            auto error = detail::makeSystemError("Could not map", path);
+            ::close(fd);
+            throw error;
+        }
+    }
+    ::close(fd);
+    return base;
+}
+
+} // anonymous
+
+
+MappedFile MappedFile::open(std::string const & path, bool writable) {
+    int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        throw detail::makeSystemError("Could not open", path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        auto error = detail::makeSystemError("Could not stat", path);
+        ::close(fd);
+        throw error;
+    }
+    std::size_t size = info.st_size;
+    void * base = mapDescriptor(fd, size, writable, path);
+    return MappedFile(std::make_shared<Mapping>(base, size, writable));
+}
+
+MappedFile MappedFile::create(std::string const & path, std::size_t size) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        throw detail::makeSystemError("Could not create", path);
+    }
+    if (::ftruncate(fd, size) != 0) {
+        auto error = detail::makeSystemError("Could not resize", path);
+        ::close(fd);
+        throw error;
+    }
+    void * base = mapDescriptor(fd, size, true, path);
+    return MappedFile(std::make_shared<Mapping>(base, size, true));
+}
+
+std::size_t MappedFile::size() const { return _mapping->size; }
+
+bool MappedFile::isWritable() const { return _mapping->writable; }
+
+char const * MappedFile::data() const { return static_cast<char const*>(_mapping->base); }
+
+char * MappedFile::writableData() const {
+    if (!_mapping->writable) {
+        throw std::logic_error("File is not mapped for writing.");
+    }
+    return static_cast<char*>(_mapping->base);
+}
+
+template <typename T>
+T * MappedFile::_view(IndexBox const & bbox, std::size_t offset, Index & stride) const {
+    if (stride == 0) {
+        stride = bbox.width();
+    }
+    if (stride < bbox.width()) {
+        throw std::invalid_argument("Stride must not be smaller than the image width.");
+    }
+    if (offset % alignof(T) != 0) {
+        throw std::invalid_argument("Offset is not a multiple of the pixel alignment.");
+    }
+    std::size_t extent = bbox.isEmpty() ? 0 : (std::size_t(stride)*(bbox.height() - 1) + bbox.width())*sizeof(T);
+    if (offset + extent > _mapping->size) {
+        throw std::out_of_range("Image extends beyond the end of the mapped file.");
+    }
+    return reinterpret_cast<T*>(static_cast<char*>(_mapping->base) + offset);
+}
+
+template <typename T>
+Image<T const> MappedFile::view(IndexBox const & bbox, std::size_t offset, Index stride) const {
+    T const * data = _view<T>(bbox, offset, stride);
+    return Image<T const>(data, bbox, ImageOwner(_mapping, reinterpret_cast<ImageStorage const*>(data)), stride);
+}
+
+template <typename T>
+Image<T> MappedFile::writableView(IndexBox const & bbox, std::size_t offset, Index stride) const {
+    writableData();  // check that the mapping is writable
+    T * data = _view<T>(bbox, offset, stride);
+    return Image<T>(data, bbox, ImageOwner(_mapping, reinterpret_cast<ImageStorage const*>(data)), stride);
+}
+
+
+template <typename T>
+Image<T> createImageFile(std::string const & path, IndexBox const & bbox, ImageLayout layout) {
+    // A PADDED file's rows are aligned relative to the (page-aligned) start
+    // of the mapping, since the header size is a multiple of the alignment.
+    Index stride = bbox.width();
+    if (layout == ImageLayout::PADDED) {
+        Index const n = IMAGE_ALIGNMENT/sizeof(T);
+        stride = (stride + n - 1)/n*n;
+    }
+    MappedFile file = MappedFile::create(
+        path,
+        IMAGE_FILE_HEADER_SIZE + std::size_t(stride)*bbox.height()*sizeof(T)
+    );
+    ImageFileHeader header;
+    std::memcpy(header.magic, IMAGE_FILE_MAGIC, sizeof(header.magic));
+    header.pixelType = static_cast<std::int32_t>(detail::PixelTypeOf<T>::value);
+    header.x0 = bbox.x0();
+    header.y0 = bbox.y0();
+    header.width = bbox.width();
+    header.height = bbox.height();
+    header.stride = stride;
+    std::memcpy(file.writableData(), &header, sizeof(header));
+    return file.writableView<T>(bbox, IMAGE_FILE_HEADER_SIZE, stride);
+}
+
+template <typename T>
+Image<T const> openImageFile(std::string const & path) {
+    MappedFile file = MappedFile::open(path, false);
+    Index stride = 0;
+    IndexBox bbox = readImageBox<T>(file, path, stride);
+    return file.view<T>(bbox, IMAGE_FILE_HEADER_SIZE, stride);
+}
+
+template <typename T>
+Image<T> openWritableImageFile(std::string const & path) {
+    MappedFile file = MappedFile::open(path, true);
+    Index stride = 0;
+    IndexBox bbox = readImageBox<T>(file, path, stride);
+    return file.writableView<T>(bbox, IMAGE_FILE_HEADER_SIZE, stride);
+}
+
+PixelType readImageFilePixelType(std::string const & path) {
+    MappedFile file = MappedFile::open(path, false);
+    return static_cast<PixelType>(readHeader(file, path).pixelType);
+}
+
+
+template <typename T>
+void advise(Image<T const> const & image, MapAdvice advice) {
+    if (image.bbox().isEmpty()) {
+        return;
+    }
+    int flag = MADV_NORMAL;
+    switch (advice) {
+    case MapAdvice::NORMAL: flag = MADV_NORMAL; break;
+    case MapAdvice::SEQUENTIAL: flag = MADV_SEQUENTIAL; break;
+    case MapAdvice::RANDOM: flag = MADV_RANDOM; break;
+    case MapAdvice::WILLNEED: flag = MADV_WILLNEED; break;
+    }
+    // madvise needs a page-aligned start, so we extend the range back to
+    // the start of the page holding the first pixel.
+    std::uintptr_t const page = ::sysconf(_SC_PAGESIZE);
+    std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(image.data());
+    std::uintptr_t end = reinterpret_cast<std::uintptr_t>(
+        image.data() + std::size_t(image.stride())*(image.bbox().height() - 1) + image.bbox().width()
+    );
+    begin -= begin % page;
+    if (::madvise(reinterpret_cast<void*>(begin), end - begin, flag) != 0) {
+        throw std::runtime_error(std::string("madvise failed: ") + std::strerror(errno));
+    }
+}
+
+
+#define CIPELLS_MAPPED_FILE_INSTANTIATE(T) \
+    template Image<T const> MappedFile::view(IndexBox const &, std::size_t, Index) const; \
+    template Image<T> MappedFile::writableView(IndexBox const &, std::size_t, Index) const; \
+    template Image<T> createImageFile(std::string const &, IndexBox const &, ImageLayout); \
+    template Image<T const> openImageFile(std::string const &); \
+    template Image<T> openWritableImageFile(std::string const &); \
+    template void advise(Image<T const> const &, MapAdvice)
+
+CIPELLS_MAPPED_FILE_INSTANTIATE(float);
+CIPELLS_MAPPED_FILE_INSTANTIATE(std::complex<float>);
+CIPELLS_MAPPED_FILE_INSTANTIATE(double);
+CIPELLS_MAPPED_FILE_INSTANTIATE(std::uint16_t);
+CIPELLS_MAPPED_FILE_INSTANTIATE(std::int32_t);
+CIPELLS_MAPPED_FILE_INSTANTIATE(Half);
+
+} // namespace cipells
@@ -0,0 +1,25 @@
+#define CIPELLS_MaskedImage_cc_SRC
+
+#include <stdexcept>
+
+#include "cipells/MaskedImage.h"
+
+namespace cipells {
+
+MaskedImage::MaskedImage(IndexBox const & bbox, ImageLayout layout) :
+    _image(bbox, layout), _mask(bbox, layout), _variance(bbox, layout)
+{}
+
+MaskedImage::MaskedImage(Image<float> image, Image<MaskPixel> mask, Image<float> variance) :
+    _image(std::move(image)), _mask(std::move(mask)), _variance(std::move(variance))
+{
+    if (_mask.bbox() != _image.bbox() || _variance.bbox() != _image.bbox()) {
+        throw std::invalid_argument("Image, mask and variance planes must have the same bounding box.");
+    }
+}
+
+MaskedImage MaskedImage::copy() const {
+    return MaskedImage(_image.copy(), _mask.copy(), _variance.copy());
+}
+
+} // namespace cipells
@@ -0,0 +1,175 @@
+#define CIPELLS_StreamingWarp_cc_SRC
+
+#include <cmath>
+#include <stdexcept>
+
+#include "cipells/StreamingWarp.h"
+
+namespace cipells {
+
+class StreamingWarp::Impl {
+public:
+
+    Impl(
+        std::shared_ptr<Interpolant const> interpolant,
+        IndexBox const & inputBBox,
+        Affine const & transform,
+        IndexBox const & outputBBox,
+        Sink sink
+    ) :
+        _interpolant(interpolant ? std::move(interpolant) : Interpolant::default_()),
+        _inputBBox(inputBBox),
+        _transform(transform),
+        _outputBBox(outputBBox),
+        _sink(std::move(sink)),
+        _height(0),
+        _nextInput(inputBBox.y0()),
+        _nextOutput(outputBBox.y0())
+    {
+        if (!std::isfinite(_interpolant->radius())) {
+            throw std::invalid_argument("Cannot stream a warp with an interpolant of infinite radius.");
+        }
+        // The ring buffer must hold the input rows of any single output row,
+        // and those rows must never move backwards from one output row to
+        // the next.
+        IndexInterval previous;
+        for (Index y = outputBBox.y0(); y <= outputBBox.y1(); ++y) {
+            IndexInterval rows = computeInputRows(y);
+            if (rows.isEmpty()) {
+                continue;
+            }
+            if (!previous.isEmpty() && (rows.min() < previous.min() || rows.max() < previous.max())) {
+                throw std::invalid_argument("Streaming warps require transforms that do not flip the y axis.");
+            }
+            _height = std::max(_height, rows.size());
+            previous = rows;
+        }
+        // Each row is stored twice, H rows apart, so any H consecutive rows
+        // are contiguous in memory and can be viewed as a single image.
+        if (_height > 0) {
+            _ring = Image<float>::makeUninitialized(
+                IndexBox(inputBBox.x(), IndexInterval::fromMinSize(0, 2*_height)),
+                ImageLayout::PADDED
+            );
+        }
+        _row = Image<float>::makeUninitialized(
+            IndexBox(outputBBox.x(), IndexInterval::fromMinSize(0, 1)),
+            ImageLayout::PADDED
+        );
+    }
+
+    void push(Image<float const> const & rows) {
+        if (rows.bbox().isEmpty()) {
+            return;
+        }
+        if (rows.bbox().x() != _inputBBox.x()) {
+            throw std::invalid_argument("Input rows must span the input bounding box.");
+        }
+        if (rows.bbox().y0() != _nextInput || rows.bbox().y1() > _inputBBox.y1()) {
+            throw std::invalid_argument("Input rows must be pushed in order, exactly once.");
+        }
+        for (Index y = rows.bbox().y0(); y <= rows.bbox().y1(); ++y) {
+            if (_height > 0) {
+                IndexBox source(rows.bbox().x(), IndexInterval::fromMinSize(y, 1));
+                Index const slot = (y - _inputBBox.y0()) % _height;
+                _ring.array(IndexBox(_ring.bbox().x(), IndexInterval::fromMinSize(slot, 1))) =
+                    rows.array(source);
+                _ring.array(IndexBox(_ring.bbox().x(), IndexInterval::fromMinSize(slot + _height, 1))) =
+                    rows.array(source);
+            }
+            ++_nextInput;
+            // Emitting as we go guarantees no row still needed is
+            // overwritten by the next one.
+            emitReady();
+        }
+    }
+
+    void finish() {
+        if (_nextInput <= _inputBBox.y1()) {
+            throw std::logic_error("Not all input rows have been pushed.");
+        }
+        emitReady();
+    }
+
+    Index bufferHeight() const { return _height; }
+
+    Index nextInputRow() const { return _nextInput; }
+
+    Index nextOutputRow() const { return _nextOutput; }
+
+private:
+
+    // Return the input rows within the interpolant's footprint of any pixel
+    // in the given output row.
+    IndexInterval computeInputRows(Index y) const {
+        IndexBox row(_outputBBox.x(), IndexInterval::fromMinSize(y, 1));
+        IndexBox region(_transform(RealBox(row)).dilatedBy(_interpolant->radius() + 1));
+        return region.y().clippedTo(_inputBBox.y());
+    }
+
+    void emitReady() {
+        for (; _nextOutput <= _outputBBox.y1(); ++_nextOutput) {
+            IndexInterval rows = computeInputRows(_nextOutput);
+            if (!rows.isEmpty() && rows.max() >= _nextInput) {
+                return;
+            }
+            Image<float> output(
+                _row.data(),
+                IndexBox(_outputBBox.x(), IndexInterval::fromMinSize(_nextOutput, 1)),
+                _row.owner(),
+                _row.stride()
+            );
+            if (rows.isEmpty()) {
+                output.array().setZero();
+            } else {
+                Index const slot = (rows.min() - _inputBBox.y0()) % _height;
+                Image<float const> window(
+                    &_ring[Index2(_inputBBox.x0(), slot)],
+                    IndexBox(_inputBBox.x(), rows),
+                    _ring.owner(),
+                    _ring.stride()
+                );
+                _interpolant->warp(window, _transform, output);
+            }
+            _sink(output);
+        }
+    }
+
+    std::shared_ptr<Interpolant const> _interpolant;
+    IndexBox _inputBBox;
+    Affine _transform;
+    IndexBox _outputBBox;
+    Sink _sink;
+    Index _height;
+    Index _nextInput;
+    Index _nextOutput;
+    Image<float> _ring;
+    Image<float> _row;
+};
+
+
+StreamingWarp::StreamingWarp(
+    std::shared_ptr<Interpolant const> interpolant,
+    IndexBox const & inputBBox,
+    Affine const & transform,
+    IndexBox const & outputBBox,
+    Sink sink
+) : _impl(new Impl(std::move(interpolant), inputBBox, transform, outputBBox, std::move(sink))) {}
+
+StreamingWarp::StreamingWarp(StreamingWarp &&) = default;
+
+StreamingWarp & StreamingWarp::operator=(StreamingWarp &&) = default;
+
+StreamingWarp::~StreamingWarp() {}
+
+void StreamingWarp::push(Image<float const> const & rows) { _impl->push(rows); }
+
+void StreamingWarp::finish() { _impl->finish(); }
+
+Index StreamingWarp::bufferHeight() const { return _impl->bufferHeight(); }
+
+Index StreamingWarp::nextInputRow() const { return _impl->nextInputRow(); }
+
+Index StreamingWarp::nextOutputRow() const { return _impl->nextOutputRow(); }
+
+} // namespace cipells
@@ -0,0 +1,440 @@
+#define CIPELLS_TiledImage_cc_SRC
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cipells/TiledImage.h"
+#include "cipells/Interpolant.h"
+#include "cipells/Kernel.h"
+#include "impl/files.h"
+
+namespace cipells {
+
+namespace {
+
+char const TILED_FILE_MAGIC[8] = {'C', 'I', 'P', 'T', 'I', 'L', 'E', '1'};
+
+struct TiledFileHeader {
+    char magic[8];
+    std::int32_t pixelType;
+    std::int32_t x0;
+    std::int32_t y0;
+    std::int32_t width;
+    std::int32_t height;
+    std::int32_t tileSize;
+};
+
+static_assert(sizeof(TiledFileHeader) <= IMAGE_FILE_HEADER_SIZE, "Tiled file header too large.");
+
+void readBytes(int fd, void * data, std::size_t size, std::size_t offset, std::string const & path) {
+    char * p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = ::pread(fd, p, size, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw detail::makeSystemError("Could not read", path);
+        }
+        if (n == 0) {
+            throw std::runtime_error("Unexpected end of file '" + path + "'.");
+        }
+        p += n;
+        size -= n;
+        offset += n;
+    }
+}
+
+void writeBytes(int fd, void const * data, std::size_t size, std::size_t offset, std::string const & path) {
+    char const * p = static_cast<char const*>(data);
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, p, size, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw detail::makeSystemError("Could not write", path);
+        }
+        p += n;
+        size -= n;
+        offset += n;
+    }
+}
+
+} // anonymous
+
+
+template <typename T>
+class TiledImage<T>::Impl {
+public:
+
+    Impl(std::string const & path, int fd, bool writable, IndexBox const & bbox, Index tileSize,
+         std::size_t maxCachedBytes) :
+        _path(path), _fd(fd), _writable(writable), _bbox(bbox), _tileSize(tileSize),
+        _nx((bbox.width() + tileSize - 1)/tileSize),
+        _tileBytes(std::size_t(tileSize)*tileSize*sizeof(T)),
+        _maxCachedBytes(maxCachedBytes),
+        _stats()
+    {}
+
+    Impl(Impl const &) = delete;
+    Impl & operator=(Impl const &) = delete;
+
+    ~Impl() {
+        try {
+            flush();
+        } catch (...) {
+            // Destructors can't throw; callers who care should flush first.
+        }
+        ::close(_fd);
+    }
+
+    IndexBox const & bbox() const { return _bbox; }
+
+    Index tileSize() const { return _tileSize; }
+
+    bool isWritable() const { return _writable; }
+
+    IndexBox getTileBBox(Index2 const & index) const {
+        return getSquare(getTileNumber(index)).clippedTo(_bbox);
+    }
+
+    Image<T> read(IndexBox const & box) {
+        Image<T> result(box, ImageLayout::PADDED);
+        IndexBox overlap = box.clippedTo(_bbox);
+        if (overlap.isEmpty()) {
+            return result;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        forEachTile(overlap, [&](Index n, IndexBox const & part) {
+            result.array(part) = getTile(n).array(part);
+        });
+        return result;
+    }
+
+    void write(Image<T const> const & image) {
+        if (!_writable) {
+            throw std::logic_error("Tiled image is not writable.");
+        }
+        IndexBox overlap = image.bbox().clippedTo(_bbox);
+        if (overlap.isEmpty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        forEachTile(overlap, [&](Index n, IndexBox const & part) {
+            // Tiles that will be completely overwritten needn't be read.
+            Entry & entry = getEntry(n, !overlap.contains(getSquare(n)));
+            entry.image.array(part) = image.array(part);
+            entry.dirty = true;
+            evict();
+        });
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto & item : _cache) {
+            if (item.second.dirty) {
+                store(item.first, item.second);
+            }
+        }
+    }
+
+    TileCacheStats stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+private:
+
+    struct Entry {
+        Image<T> image;
+        bool dirty;
+        std::list<Index>::iterator position;
+    };
+
+    Index getTileNumber(Index2 const & index) const {
+        return ((index.y() - _bbox.y0())/_tileSize)*_nx + (index.x() - _bbox.x0())/_tileSize;
+    }
+
+    // Return the full (unclipped) box of the given tile, which is what is
+    // stored in the file and the cache.
+    IndexBox getSquare(Index n) const {
+        return IndexBox::fromMinSize(
+            _bbox.min() + Index2(n % _nx, n / _nx)*_tileSize,
+            Index2(_tileSize, _tileSize)
+        );
+    }
+
+    // Call func(n, part) for each tile n that overlaps the given box, which
+    // must be within the image's bounding box.
+    template <typename Func>
+    void forEachTile(IndexBox const & box, Func func) const {
+        Index2 const first = (box.min() - _bbox.min())/_tileSize;
+        Index2 const last = (box.max() - _bbox.min())/_tileSize;
+        for (Index j = first.y(); j <= last.y(); ++j) {
+            for (Index i = first.x(); i <= last.x(); ++i) {
+                Index const n = j*_nx + i;
+                func(n, getSquare(n).clippedTo(box));
+            }
+        }
+    }
+
+    std::size_t getOffset(Index n) const {
+        return IMAGE_FILE_HEADER_SIZE + std::size_t(n)*_tileBytes;
+    }
+
+    void store(Index n, Entry & entry) {
+        writeBytes(_fd, entry.image.data(), _tileBytes, getOffset(n), _path);
+        entry.dirty = false;
+        ++_stats.writes;
+    }
+
+    // Return the cached image for a tile.  The caller must hold the mutex
+    // and finish with the tile before calling evict().
+    Entry & getEntry(Index n, bool load) {
+        auto iter = _cache.find(n);
+        if (iter != _cache.end()) {
+            ++_stats.hits;
+            _lru.splice(_lru.begin(), _lru, iter->second.position);
+            return iter->second;
+        }
+        ++_stats.misses;
+        auto image = Image<T>::makeUninitialized(getSquare(n));
+        if (load) {
+            readBytes(_fd, image.data(), _tileBytes, getOffset(n), _path);
+        }
+        _lru.push_front(n);
+        Entry & entry = _cache[n];
+        entry.image = std::move(image);
+        entry.dirty = false;
+        entry.position = _lru.begin();
+        _stats.bytesCached += _tileBytes;
+        return entry;
+    }
+
+    // Return a tile's image for reading, evicting others if necessary.  The
+    // returned image holds the pixels even if the tile is later evicted.
+    Image<T> getTile(Index n) {
+        Image<T> result = getEntry(n, true).image;
+        evict();
+        return result;
+    }
+
+    // Drop the least-recently-used tiles (writing them if modified) until
+    // the cache is within its budget, always keeping the most recent tile.
+    void evict() {
+        while (_stats.bytesCached > _maxCachedBytes && _lru.size() > 1u) {
+            Index n = _lru.back();
+            auto iter = _cache.find(n);
+            if (iter->second.dirty) {
+                store(n, iter->second);
+            }
+            _cache.erase(iter);
+            _lru.pop_back();
+            _stats.bytesCached -= _tileBytes;
+        }
+    }
+
+    std::string const _path;
+    int const _fd;
+    bool const _writable;
+    IndexBox const _bbox;
+    Index const _tileSize;
+    Index const _nx;
+    std::size_t const _tileBytes;
+    std::size_t const _maxCachedBytes;
+    mutable std::mutex _mutex;
+    std::list<Index> _lru;
+    std::unordered_map<Index, Entry> _cache;
+    TileCacheStats _stats;
+};
+
+
+template <typename T>
+TiledImage<T> TiledImage<T>::create(std::string const & path, IndexBox const & bbox, Index tileSize,
+                                    std::size_t maxCachedBytes) {
+    if (tileSize <= 0) {
+        throw std::invalid_argument("Tile size must be positive.");
+    }
+    Index const nx = (bbox.width() + tileSize - 1)/tileSize;
+    Index const ny = (bbox.height() + tileSize - 1)/tileSize;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        throw detail::makeSystemError("Could not create", path);
+    }
+    auto impl = std::make_shared<Impl>(path, fd, true, bbox, tileSize, maxCachedBytes);
+    // The file is sparse until tiles are written, and unwritten tiles read
+    // as zeros.
+    if (::ftruncate(fd, IMAGE_FILE_HEADER_SIZE + std::size_t(nx)*ny*tileSize*tileSize*sizeof(T)) != 0) {
+        throw detail::makeSystemError("Could not resize", path);
+    }
+    TiledFileHeader header;
+    std::memcpy(header.magic, TILED_FILE_MAGIC, sizeof(header.magic));
+    header.pixelType = static_cast<std::int32_t>(detail::PixelTypeOf<T>::value);
+    header.x0 = bbox.x0();
+    header.y0 = bbox.y0();
+    header.width = bbox.width();
+    header.height = bbox.height();
+    header.tileSize = tileSize;
+    writeBytes(fd, &header, sizeof(header), 0, path);
+    return TiledImage(std::move(impl));
+}
+
+template <typename T>
+TiledImage<T> TiledImage<T>::open(std::string const & path, bool writable, std::size_t maxCachedBytes) {
+    int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        throw detail::makeSystemError("Could not open", path);
+    }
+    TiledFileHeader header;
+    try {
+        readBytes(fd, &header, sizeof(header), 0, path);
+        if (std::memcmp(header.magic, TILED_FILE_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("File '" + path + "' is not a tiled image file.");
+        }
+        if (header.pixelType != static_cast<std::int32_t>(detail::PixelTypeOf<T>::value)) {
+            throw std::runtime_error("Tiled image file '" + path + "' has the wrong pixel type.");
+        }
+        if (header.tileSize <= 0 || header.width < 0 || header.height < 0) {
+            throw std::runtime_error("Tiled image file '" + path + "' has an invalid header.");
+        }
+        // Every tile is stored in full, as in create.  We divide rather than
+        // multiply so a corrupt header can't overflow.
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            throw detail::makeSystemError("Could not stat", path);
+        }
+        std::size_t const available = std::size_t(st.st_size) > IMAGE_FILE_HEADER_SIZE ?
+            std::size_t(st.st_size) - IMAGE_FILE_HEADER_SIZE : 0;
+        std::size_t const tileSize = header.tileSize;
+        std::size_t const tileCount = std::size_t((header.width + tileSize - 1)/tileSize)*
+            ((header.height + tileSize - 1)/tileSize);
+        if (tileCount > 0 && (
+                tileSize > available/tileSize/sizeof(T) ||
+                tileCount > available/(tileSize*tileSize*sizeof(T))
+        )) {
+            throw std::runtime_error("Tiled image file '" + path + "' is truncated.");
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    IndexBox bbox = IndexBox::fromMinSize(Index2(header.x0, header.y0), Index2(header.width, header.height));
+    return TiledImage(std::make_shared<Impl>(path, fd, writable, bbox, header.tileSize, maxCachedBytes));
+}
+
+template <typename T>
+IndexBox const & TiledImage<T>::bbox() const { return _impl->bbox(); }
+
+template <typename T>
+Index TiledImage<T>::tileSize() const { return _impl->tileSize(); }
+
+template <typename T>
+bool TiledImage<T>::isWritable() const { return _impl->isWritable(); }
+
+template <typename T>
+IndexBox TiledImage<T>::getTileBBox(Index2 const & index) const {
+    if (!bbox().contains(index)) {
+        throw std::out_of_range("Index is not within the tiled image.");
+    }
+    return _impl->getTileBBox(index);
+}
+
+template <typename T>
+Image<T> TiledImage<T>::read(IndexBox const & box) const { return _impl->read(box); }
+
+template <typename T>
+void TiledImage<T>::write(Image<T const> const & image) const { _impl->write(image); }
+
+template <typename T>
+void TiledImage<T>::flush() const { _impl->flush(); }
+
+template <typename T>
+TileCacheStats TiledImage<T>::stats() const { return _impl->stats(); }
+
+template class TiledImage<float>;
+template class TiledImage<std::complex<float>>;
+
+
+namespace {
+
+// Compute each tile of the output from the part of the input within the
+// given margin of its preimage, in row-major tile order (so consecutive
+// output tiles mostly need the same input tiles).
+template <typename Func>
+void streamTiles(TiledImage<float> const & input, Affine const & toInput, Real margin,
+                 TiledImage<float> const & output, Func func) {
+    if (!output.isWritable()) {
+        throw std::logic_error("Tiled output image is not writable.");
+    }
+    IndexBox const & bbox = output.bbox();
+    for (Index y = bbox.y0(); y <= bbox.y1(); y += output.tileSize()) {
+        for (Index x = bbox.x0(); x <= bbox.x1(); x += output.tileSize()) {
+            IndexBox tile = output.getTileBBox(Index2(x, y));
+            IndexBox region(toInput(RealBox(tile)).dilatedBy(margin));
+            region.clipTo(input.bbox());
+            auto result = Image<float>::makeUninitialized(tile, ImageLayout::PADDED);
+            if (region.isEmpty()) {
+                result.array().setZero();
+            } else {
+                func(input.read(region), result);
+            }
+            output.write(result);
+        }
+    }
+}
+
+} // anonymous
+
+
+void warp(
+    Interpolant const & interpolant,
+    TiledImage<float> const & input,
+    Affine const & transform,
+    TiledImage<float> const & output
+) {
+    if (!std::isfinite(interpolant.radius())) {
+        throw std::invalid_argument("Cannot warp tiled images with an interpolant of infinite radius.");
+    }
+    streamTiles(
+        input, transform, interpolant.radius() + 1, output,
+        [&](Image<float const> const & in, Image<float> const & out) {
+            interpolant.warp(in, transform, out);
+        }
+    );
+}
+
+void convolve(
+    Kernel const & kernel,
+    TiledImage<float> const & input,
+    Affine const & transform,
+    TiledImage<float> const & output,
+    bool transpose
+) {
+    Real const radius = kernel.interpolant()->radius();
+    if (!std::isfinite(radius)) {
+        throw std::invalid_argument("Cannot convolve tiled images with an interpolant of infinite radius.");
+    }
+    // Each output pixel sees input pixels within the kernel's extent plus
+    // the interpolant's radius, both measured on the upsampled grid.
+    IndexBox const & k = kernel.image().bbox();
+    Real const reach = std::max(std::max(std::abs(k.x0()), std::abs(k.x1())),
+                                std::max(std::abs(k.y0()), std::abs(k.y1())));
+    streamTiles(
+        input, transform.inverted(), (reach + radius + 1)/kernel.upsampling() + 1, output,
+        [&](Image<float const> const & in, Image<float> const & out) {
+            if (transpose) {
+                kernel.correlate(in, transform, out);
+            } else {
+                kernel.convolve(in, transform, out);
+            }
+        }
+    );
+}
+
+} // namespace cipells
@@ -0,0 +1,63 @@
+#ifndef CIPELLS_IMPL_fft_h_INCLUDED
+#define CIPELLS_IMPL_fft_h_INCLUDED
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+
+#include "unsupported/Eigen/FFT"
+#include "cipells/Image.h"
+
+namespace cipells { namespace detail {
+
+using FFT = Eigen::FFT<float>;
+
+// Return an FFT engine for the calling thread.  The engine caches its plans
+// (twiddle factors and factorizations) for each transform size it sees, so
+// reusing it makes repeated transforms of the same shape cheap.  Transforms
+// are unscaled in both directions.
+inline FFT & getFFT() {
+    thread_local FFT fft = []() {
+        FFT result;
+        result.SetFlag(FFT::Unscaled);
+        return result;
+    }();
+    return fft;
+}
+
+// Transform each row and then each column of the given image in place,
+// using the calling thread's engine.
+inline void transform2d(Image<std::complex<float>> const & image, bool inverse) {
+    FFT & fft = getFFT();
+    Index const width = image.bbox().width();
+    Index const height = image.bbox().height();
+    std::vector<std::complex<float>> in(std::max(width, height));
+    std::vector<std::complex<float>> out(std::max(width, height));
+    for (Index i = 0; i < height; ++i) {
+        std::complex<float> * row = image.data() + i*image.stride();
+        std::copy(row, row + width, in.begin());
+        if (inverse) {
+            fft.inv(row, in.data(), width);
+        } else {
+            fft.fwd(row, in.data(), width);
+        }
+    }
+    for (Index j = 0; j < width; ++j) {
+        std::complex<float> * column = image.data() + j;
+        for (Index i = 0; i < height; ++i) {
+            in[i] = column[i*image.stride()];
+        }
+        if (inverse) {
+            fft.inv(out.data(), in.data(), height);
+        } else {
+            fft.fwd(out.data(), in.data(), height);
+        }
+        for (Index i = 0; i < height; ++i) {
+            column[i*image.stride()] = out[i];
+        }
+    }
+}
+
+}} // namespace cipells::detail
+
+#endif // !CIPELLS_IMPL_fft_h_INCLUDED
@@ -0,0 +1,54 @@
+#ifndef CIPELLS_IMPL_files_h_INCLUDED
+#define CIPELLS_IMPL_files_h_INCLUDED
+
+#include <cerrno>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "cipells/MappedFile.h"
+
+namespace cipells { namespace detail {
+
+inline std::runtime_error makeSystemError(std::string const & what, std::string const & path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+template <typename T>
+struct PixelTypeOf;
+
+template <>
+struct PixelTypeOf<float> {
+    static constexpr PixelType value = PixelType::FLOAT32;
+};
+
+template <>
+struct PixelTypeOf<std::complex<float>> {
+    static constexpr PixelType value = PixelType::COMPLEX64;
+};
+
+template <>
+struct PixelTypeOf<double> {
+    static constexpr PixelType value = PixelType::FLOAT64;
+};
+
+template <>
+struct PixelTypeOf<std::uint16_t> {
+    static constexpr PixelType value = PixelType::UINT16;
+};
+
+template <>
+struct PixelTypeOf<std::int32_t> {
+    static constexpr PixelType value = PixelType::INT32;
+};
+
+template <>
+struct PixelTypeOf<Half> {
+    static constexpr PixelType value = PixelType::FLOAT16;
+};
+
+}} // namespace cipells::detail
+
+#endif // !CIPELLS_IMPL_files_h_INCLUDED
@@ -0,0 +1,125 @@
+#ifndef CIPELLS_IMPL_upsampling_h_INCLUDED
+#define CIPELLS_IMPL_upsampling_h_INCLUDED
+
+#include <cmath>
+
+#include "Eigen/Core"
+#include "cipells/Interval.h"
+#include "cipells/Image.h"
+#include "cipells/transforms.h"
+#include "cipells/parallel.h"
+
+namespace cipells { namespace detail {
+
+inline Index floorDiv(Index x, Index y) {
+    return x/y - (x % y != 0 && (x < 0) != (y < 0));
+}
+
+inline Index ceilDiv(Index x, Index y) {
+    return -floorDiv(-x, y);
+}
+
+// Return the interval of integers q for which upsampling*q + offset lies in
+// the given interval.
+inline IndexInterval computeStuffedRange(IndexInterval const & fine, Index offset, Index upsampling) {
+    return IndexInterval::fromMinMax(
+        ceilDiv(fine.min() - offset, upsampling),
+        floorDiv(fine.max() - offset, upsampling)
+    );
+}
+
+// Return the bounding box of the upsampled grid that a kernel with the given
+// bounding box reaches from the input pixels.
+inline IndexBox computeStuffedBBox(IndexBox const & input, IndexBox const & kernel, Index upsampling) {
+    return IndexBox::fromMinMax(input.min()*upsampling + kernel.min(), input.max()*upsampling + kernel.max());
+}
+
+using StuffedWeights = Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// Return the weights that stuff input pixels onto the upsampled grid.
+// Convolution with an upsampled kernel only sees every u-th kernel pixel in
+// each dimension, so we scale by u^2 to preserve flux; correlation uses the
+// reversed kernel.
+inline StuffedWeights computeStuffedWeights(Image<float const> const & kernel, Index upsampling, bool transpose) {
+    StuffedWeights result = kernel.array()*(upsampling*upsampling);
+    if (transpose) {
+        result = result.reverse().eval();
+    }
+    return result;
+}
+
+// Call func(target, weight, source) for each kernel pixel, where target is
+// the strided view of the pixels of the stuffed image that the pixel maps
+// the source input pixels onto.  Only the pixels within the stuffed image's
+// bounding box are visited.
+template <typename Input, typename Weights, typename T, typename Func>
+void stuffKernel(
+    Input const & input,
+    Weights const & weights,
+    Index2 const & kernelMin,
+    Index u,
+    Image<T> const & stuffed,
+    Func func
+) {
+    using Target = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+                              Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+    for (Index i = 0; i < weights.rows(); ++i) {
+        Index const jy = kernelMin.y() + i;
+        IndexInterval qy = computeStuffedRange(stuffed.bbox().y(), jy, u).clipTo(input.bbox().y());
+        if (qy.isEmpty()) continue;
+        for (Index j = 0; j < weights.cols(); ++j) {
+            Index const jx = kernelMin.x() + j;
+            IndexInterval qx = computeStuffedRange(stuffed.bbox().x(), jx, u).clipTo(input.bbox().x());
+            if (qx.isEmpty()) continue;
+            Target target(
+                &stuffed[Index2(u*qx.min() + jx, u*qy.min() + jy)],
+                qy.size(), qx.size(),
+                Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(u*stuffed.stride(), u)
+            );
+            func(target, weights(i, j), input.array(IndexBox(qx, qy)));
+        }
+    }
+}
+
+// Call func(tile, region) in parallel for each tile of the output bounding
+// box, where region is the part of the upsampled bounding box that an
+// interpolant with the given radius reads when warping onto that tile with
+// the given transform (from output to upsampled coordinates).  Interpolants
+// with infinite radius read all of it for every tile, so the output is then
+// processed as a single tile.
+template <typename Func>
+void forEachStuffedTile(
+    IndexBox const & output,
+    IndexBox const & bounds,
+    Affine const & fine,
+    Real radius,
+    Index2 tileSize,
+    Func func
+) {
+    if (output.isEmpty()) {
+        return;
+    }
+    if (!std::isfinite(radius)) {
+        tileSize = output.size();
+    }
+    Index const nx = (output.width() + tileSize.x() - 1)/tileSize.x();
+    Index const ny = (output.height() + tileSize.y() - 1)/tileSize.y();
+    parallelFor(
+        nx*ny,
+        [&](Index n) {
+            IndexBox tile = IndexBox::fromMinSize(
+                output.min() + Index2((n % nx)*tileSize.x(), (n / nx)*tileSize.y()),
+                tileSize
+            ).clippedTo(output);
+            IndexBox region = bounds;
+            if (std::isfinite(radius)) {
+                region.clipTo(IndexBox(fine(RealBox(tile)).dilatedBy(radius + 1)));
+            }
+            func(tile, region);
+        }
+    );
+}
+
+}} // namespace cipells::detail
+
+#endif // !CIPELLS_IMPL_upsampling_h_INCLUDED
@@ -0,0 +1,170 @@
+#define CIPELLS_parallel_cc_SRC
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "cipells/parallel.h"
+
+namespace cipells {
+
+namespace {
+
+thread_local bool inPoolTask = false;
+
+class ThreadPool {
+public:
+
+    static ThreadPool & get() {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+
+    ThreadPool & operator=(ThreadPool const &) = delete;
+    ThreadPool & operator=(ThreadPool &&) = delete;
+
+    Index size() const { return _size; }
+
+    void resize(Index n) {
+        std::lock_guard<std::mutex> run(_run);
+        stop();
+        _size = n;
+        _stopping = false;
+        for (Index i = 1; i < _size; ++i) {
+            _workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    void run(Index n, std::function<void(Index)> const & func) {
+        std::lock_guard<std::mutex> run(_run);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _func = &func;
+            _n = n;
+            _next = 0;
+            _pending = n;
+            _error = nullptr;
+            ++_generation;
+        }
+        _wake.notify_all();
+        process();
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]() { return _pending == 0; });
+        _func = nullptr;
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+    }
+
+    ~ThreadPool() { stop(); }
+
+private:
+
+    ThreadPool() : _size(1), _stopping(false), _func(nullptr), _n(0), _next(0), _pending(0), _generation(0) {}
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto & worker : _workers) {
+            worker.join();
+        }
+        _workers.clear();
+    }
+
+    void work() {
+        std::size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this, seen]() { return _stopping || _generation != seen; });
+                if (_stopping) {
+                    return;
+                }
+                seen = _generation;
+            }
+            process();
+        }
+    }
+
+    // Claim and run tasks until there are none left.
+    void process() {
+        inPoolTask = true;
+        Index completed = 0;
+        for (Index i = _next++; i < _n; i = _next++) {
+            try {
+                (*_func)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_error) {
+                    _error = std::current_exception();
+                }
+            }
+            ++completed;
+        }
+        inPoolTask = false;
+        if (completed) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending -= completed;
+            if (_pending == 0) {
+                _done.notify_all();
+            }
+        }
+    }
+
+    Index _size;
+    bool _stopping;
+    std::vector<std::thread> _workers;
+    std::mutex _run;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    std::function<void(Index)> const * _func;
+    Index _n;
+    std::atomic<Index> _next;
+    Index _pending;
+    std::exception_ptr _error;
+    std::size_t _generation;
+};
+
+} // anonymous
+
+void setThreadCount(Index n) {
+    if (n < 0) {
+        throw std::invalid_argument("Thread count must be nonnegative.");
+    }
+    if (n == 0) {
+        n = std::max(static_cast<Index>(std::thread::hardware_concurrency()), Index(1));
+    }
+    ThreadPool::get().resize(n);
+}
+
+Index getThreadCount() {
+    return ThreadPool::get().size();
+}
+
+namespace detail {
+
+void parallelFor(Index n, std::function<void(Index)> const & func) {
+    if (inPoolTask || n <= 1 || ThreadPool::get().size() <= 1) {
+        for (Index i = 0; i < n; ++i) {
+            func(i);
+        }
+        return;
+    }
+    ThreadPool::get().run(n, func);
+}
+
+} // namespace detail
+
+} // namespace cipells
@@ -1,13 +1,531 @@
 #define CIPELLS_profiles_cc_SRC
 
 #include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "unsupported/Eigen/SpecialFunctions"
 
 #include "cipells/profiles.h"
 #include "cipells/Image.h"
+#include "cipells/Kernel.h"
+#include "cipells/parallel.h"
 #include "impl/formatting.h"
+#include "impl/fft.h"
 
 namespace cipells {
 
+namespace {
+
+// Bounds on the number of Gauss-Legendre nodes used to integrate sheared
+// profiles over the height of each pixel.
+constexpr int MIN_QUADRATURE_ORDER = 4;
+constexpr int MAX_QUADRATURE_ORDER = 32;
+
+// Number of profiles whose footprints are computed in each task when
+// binning a catalog.
+constexpr Index FOOTPRINT_CHUNK_SIZE = 4096;
+
+// Relative amplitude (as -log) below which Fourier-space aliases of a
+// profile are neglected, and the largest number of aliases (in each
+// direction) included.
+constexpr double ALIAS_EXPONENT = 20.0;
+constexpr Index MAX_ALIASES = 8;
+
+// Compute the nodes and weights of n-point Gauss-Legendre quadrature over
+// [-0.5, 0.5], with the weights normalized to sum to one.
+void computeQuadrature(int n, Eigen::ArrayXd & nodes, Eigen::ArrayXd & weights) {
+    nodes.resize(n);
+    weights.resize(n);
+    for (int i = 0; i < n; ++i) {
+        // Newton iteration for the i-th root of the Legendre polynomial P_n,
+        // starting from an asymptotic approximation.
+        double x = std::cos(M_PI*(i + 0.75)/(n + 0.5));
+        double dp = 0.0;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            double p0 = 1.0;
+            double p1 = x;
+            for (int k = 2; k <= n; ++k) {
+                double const p2 = ((2*k - 1)*x*p1 - (k - 1)*p0)/k;
+                p0 = p1;
+                p1 = p2;
+            }
+            dp = n*(x*p1 - p0)/(x*x - 1.0);
+            double const delta = p1/dp;
+            x -= delta;
+            if (std::abs(delta) < 1E-15) {
+                break;
+            }
+        }
+        nodes[i] = 0.5*x;
+        weights[i] = 1.0/((1.0 - x*x)*dp*dp);
+    }
+}
+
+// Return the fraction of a 1-d Gaussian with the given center and width
+// that falls in each of the unit pixels centered on the elements of x.
+Eigen::ArrayXd integratePixels(Eigen::ArrayXd const & x, double center, double sigma) {
+    double const scale = 1.0/(std::sqrt(2.0)*sigma);
+    return 0.5*(((x - center + 0.5)*scale).erf() - ((x - center - 0.5)*scale).erf());
+}
+
+// Return the matrix f of the ellipse u^T f^{-1} u <= 1 (with u the offset
+// from the center) within which Gaussian::addTo draws pixels whose centers
+// lie.  When integrating, the nSigma ellipse is enlarged to one containing
+// every pixel that overlaps it, i.e. (a bound on) the sum of that ellipse and
+// a disk of radius equal to the pixel half-diagonal.
+Eigen::Matrix2d computeFootprintMatrix(
+    Eigen::Matrix2d const & covariance,
+    Real nSigma,
+    Gaussian::DrawMethod method
+) {
+    Eigen::Matrix2d f = nSigma*nSigma*covariance;
+    if (method == Gaussian::DrawMethod::INTEGRATE) {
+        double const r2 = 0.5;
+        double const t = std::sqrt(f.trace()/(2*r2));
+        f = (1.0 + 1.0/t)*f + (1.0 + t)*r2*Eigen::Matrix2d::Identity();
+    }
+    return f;
+}
+
+// Return the box of pixels whose centers lie within the bounding box of a
+// footprint ellipse.
+IndexBox computeFootprintBox(Real2 const & center, Eigen::Matrix2d const & f) {
+    return IndexBox(
+        IndexInterval::fromMinMax(
+            std::ceil(center.x() - std::sqrt(f(0, 0))),
+            std::floor(center.x() + std::sqrt(f(0, 0)))
+        ),
+        IndexInterval::fromMinMax(
+            std::ceil(center.y() - std::sqrt(f(1, 1))),
+            std::floor(center.y() + std::sqrt(f(1, 1)))
+        )
+    );
+}
+
+// Adds a single Gaussian to the rows of an image that overlap its
+// footprint, with everything that does not depend on the row computed once
+// at construction.
+class GaussianRenderer {
+public:
+
+    // Prepare to draw the given profile into the pixels within clip.
+    GaussianRenderer(Gaussian const & gaussian, Real nSigma, Gaussian::DrawMethod method,
+                     IndexBox const & clip);
+
+    // Box of pixels that addRow may modify.
+    IndexBox const & bbox() const { return _box; }
+
+    // Add the profile to the pixels of row y in columns x, starting at the
+    // given pointer.
+    void addRow(Index y, IndexInterval const & x, float * row) const;
+
+private:
+
+    enum class Path { SAMPLE_SEPARABLE, SAMPLE_RECURRENCE, INTEGRATE_SEPARABLE, INTEGRATE_QUADRATURE };
+
+    Path _path;
+    Real2 _center;
+    double _flux;
+    // Footprint ellipse (see computeFootprintMatrix).
+    Eigen::Matrix2d _f;
+    double _fDet;
+    IndexBox _box;
+    // In terms of the offset (dx, dy) from the center, the exponent is -q/2
+    // with q = p00*dx^2 + 2*p01*dx*dy + p11*dy^2, where p is the inverse of
+    // the covariance matrix.
+    Eigen::Matrix2d _p;
+    double _norm;
+    // Per-column and per-row factors for separable profiles.
+    Eigen::ArrayXf _fx;
+    Eigen::ArrayXd _fy;
+    // Conditional distribution of x at fixed y, and quadrature rule in y,
+    // for integrating sheared profiles.
+    double _slope;
+    double _sigmaY;
+    double _xScale;
+    Eigen::ArrayXd _nodes;
+    Eigen::ArrayXd _weights;
+};
+
+GaussianRenderer::GaussianRenderer(
+    Gaussian const & gaussian,
+    Real nSigma,
+    Gaussian::DrawMethod method,
+    IndexBox const & clip
+) :
+    _center(gaussian.transform().vector()),
+    _flux(gaussian.flux())
+{
+    auto const & m = gaussian.transform().matrix();
+    Eigen::Matrix2d const covariance = m*m.transpose();
+    _f = computeFootprintMatrix(covariance, nSigma, method);
+    _fDet = _f(0, 0)*_f(1, 1) - _f(0, 1)*_f(0, 1);
+    _box = computeFootprintBox(_center, _f).clippedTo(clip);
+    if (_box.isEmpty()) {
+        _path = Path::SAMPLE_RECURRENCE;
+        return;
+    }
+    bool const separable = covariance(0, 1) == 0.0;
+    if (method == Gaussian::DrawMethod::INTEGRATE) {
+        _sigmaY = std::sqrt(covariance(1, 1));
+        if (separable) {
+            // Axis-aligned profiles integrate exactly to a product of the
+            // per-column and per-row fractions.
+            _path = Path::INTEGRATE_SEPARABLE;
+            _fx = integratePixels(
+                Eigen::ArrayXd::LinSpaced(_box.width(), _box.x0(), _box.x1()),
+                _center.x(), std::sqrt(covariance(0, 0))
+            ).cast<float>();
+            _fy = _flux*integratePixels(
+                Eigen::ArrayXd::LinSpaced(_box.height(), _box.y0(), _box.y1()),
+                _center.y(), _sigmaY
+            );
+            return;
+        }
+        // Otherwise, the distribution of x at fixed y is a Gaussian whose
+        // center moves linearly with y, so the integral over the width of
+        // each pixel is exact, and the integral over its height uses
+        // Gauss-Legendre quadrature with enough nodes to resolve the narrower
+        // of the scales on which the marginal density in y and the
+        // conditional center in x vary.
+        _path = Path::INTEGRATE_QUADRATURE;
+        _slope = covariance(0, 1)/covariance(1, 1);
+        double const sigmaX = std::sqrt(covariance(0, 0) - _slope*covariance(0, 1));
+        double const scale = std::min(_sigmaY, sigmaX/std::abs(_slope));
+        int const order = std::max(
+            MIN_QUADRATURE_ORDER,
+            std::min(MAX_QUADRATURE_ORDER, static_cast<int>(std::ceil(4.0/scale)))
+        );
+        computeQuadrature(order, _nodes, _weights);
+        _xScale = 1.0/(std::sqrt(2.0)*sigmaX);
+        return;
+    }
+    double const det = covariance(0, 0)*covariance(1, 1) - covariance(0, 1)*covariance(0, 1);
+    _p << covariance(1, 1)/det, -covariance(0, 1)/det, -covariance(0, 1)/det, covariance(0, 0)/det;
+    _norm = _flux/(2*M_PI*std::sqrt(det));
+    if (separable) {
+        // Axis-aligned profiles are separable: precompute the factor for
+        // each column, and each row adds a scaled slice of it.
+        _path = Path::SAMPLE_SEPARABLE;
+        Eigen::ArrayXd const dx = Eigen::ArrayXd::LinSpaced(
+            _box.width(), _box.x0() - _center.x(), _box.x1() - _center.x()
+        );
+        _fx = (-0.5*_p(0, 0)*dx.square()).exp().cast<float>();
+    } else {
+        _path = Path::SAMPLE_RECURRENCE;
+    }
+}
+
+void GaussianRenderer::addRow(Index y, IndexInterval const & x, float * row) const {
+    if (!_box.y().contains(y)) {
+        return;
+    }
+    // Clip the row to the chord of the footprint ellipse.
+    double const dy = y - _center.y();
+    double const remainder = 1.0 - dy*dy/_f(1, 1);
+    if (remainder < 0.0) {
+        return;
+    }
+    double const xc = _center.x() + _f(0, 1)/_f(1, 1)*dy;
+    double const half = std::sqrt(remainder*_fDet/_f(1, 1));
+    IndexInterval const span = IndexInterval::fromMinMax(
+        std::ceil(xc - half), std::floor(xc + half)
+    ).clippedTo(x).clippedTo(_box.x());
+    if (span.isEmpty()) {
+        return;
+    }
+    Eigen::Map<Eigen::ArrayXf> output(row + (span.min() - x.min()), span.size());
+    switch (_path) {
+    case Path::SAMPLE_SEPARABLE:
+        output += static_cast<float>(_norm*std::exp(-0.5*_p(1, 1)*dy*dy)) *
+            _fx.segment(span.min() - _box.x0(), span.size());
+        break;
+    case Path::SAMPLE_RECURRENCE: {
+        // Along each row, the ratio between adjacent pixels' values changes
+        // by a constant factor, so after one exp() per row each pixel needs
+        // only two multiplies.
+        double const dx = span.min() - _center.x();
+        double const step = std::exp(-_p(0, 0));
+        double value = _norm*std::exp(-0.5*(_p(0, 0)*dx*dx + 2*_p(0, 1)*dx*dy + _p(1, 1)*dy*dy));
+        double ratio = std::exp(-0.5*(_p(0, 0)*(2*dx + 1) + 2*_p(0, 1)*dy));
+        for (Index i = 0; i < span.size(); ++i) {
+            output[i] += value;
+            value *= ratio;
+            ratio *= step;
+        }
+        break;
+    }
+    case Path::INTEGRATE_SEPARABLE:
+        output += static_cast<float>(_fy[y - _box.y0()])*_fx.segment(span.min() - _box.x0(), span.size());
+        break;
+    case Path::INTEGRATE_QUADRATURE: {
+        // Pixel edges, in units of the conditional width.
+        Eigen::ArrayXd const edges = _xScale*Eigen::ArrayXd::LinSpaced(
+            span.size() + 1, span.min() - 0.5, span.max() + 0.5
+        );
+        Eigen::ArrayXd sum = Eigen::ArrayXd::Zero(span.size());
+        Eigen::ArrayXd cdf(span.size() + 1);
+        for (Index k = 0; k < _nodes.size(); ++k) {
+            double const d = dy + _nodes[k];
+            double const density = std::exp(-0.5*d*d/(_sigmaY*_sigmaY))/(std::sqrt(2*M_PI)*_sigmaY);
+            cdf = (edges - _xScale*(_center.x() + _slope*d)).erf();
+            sum += (0.5*_weights[k]*density)*(cdf.tail(span.size()) - cdf.head(span.size()));
+        }
+        output += (_flux*sum).cast<float>();
+        break;
+    }
+    }
+}
+
+// Return the Fourier transform of the response of a unit pixel at each of
+// the given wavenumbers.
+Eigen::ArrayXd computePixelResponse(Eigen::ArrayXd const & k) {
+    return (k == 0.0).select(1.0, (0.5*k).sin()/(0.5*k));
+}
+
+// Return the smallest size no smaller than n with no prime factors larger
+// than 5, for which FFTs are efficient.
+Index computeFFTSize(Index n) {
+    for (Index result = std::max(n, Index(1)); ; ++result) {
+        Index m = result;
+        for (Index p : {2, 3, 5}) {
+            while (m % p == 0) {
+                m /= p;
+            }
+        }
+        if (m == 1) {
+            return result;
+        }
+    }
+}
+
+// Index of an element of an FFT of the given size, for a possibly negative
+// frequency or position.
+Index wrapIndex(Index i, Index n) {
+    return ((i % n) + n) % n;
+}
+
+// Add the Fourier transform of a Gaussian to an image on a k-space grid,
+// with pixel (i, j) at wavevector (i*kStep.x + kOffset.x, j*kStep.y +
+// kOffset.y); see Gaussian::addKTo.
+void addKValues(
+    Gaussian const & gaussian,
+    Image<std::complex<float>> const & image,
+    Real2 const & kStep,
+    Real2 const & kOffset,
+    Gaussian::DrawMethod method
+) {
+    IndexBox const & box = image.bbox();
+    if (box.isEmpty()) {
+        return;
+    }
+    // The exponent is separable except for the cross term in the covariance,
+    // so the per-column factors are computed once.  With a cross term, the
+    // exponent is summed before exponentiating: the separate factors can
+    // overflow and underflow (giving NaN) for elongated components at large
+    // wavenumbers, even though their product is small.
+    auto const & m = gaussian.transform().matrix();
+    Eigen::Matrix2d const covariance = m*m.transpose();
+    bool const separable = (covariance(0, 1) == 0.0);
+    Real2 const center(gaussian.transform().vector());
+    Eigen::ArrayXd const kx = Eigen::ArrayXd::LinSpaced(
+        box.width(), box.x0()*kStep.x() + kOffset.x(), box.x1()*kStep.x() + kOffset.x()
+    );
+    Eigen::ArrayXd const ex = -0.5*covariance(0, 0)*kx.square();
+    Eigen::ArrayXcd fx = (std::complex<double>(0.0, -center.x())*kx.cast<std::complex<double>>()).exp();
+    if (separable) {
+        fx *= ex.exp().cast<std::complex<double>>();
+    }
+    if (method == Gaussian::DrawMethod::INTEGRATE) {
+        fx *= computePixelResponse(kx).cast<std::complex<double>>();
+    }
+    auto func = [&](Index y, IndexInterval const & x, std::complex<float> * row) {
+        double const ky = y*kStep.y() + kOffset.y();
+        double const ey = -0.5*covariance(1, 1)*ky*ky;
+        std::complex<double> fy = gaussian.flux()*std::polar(1.0, -ky*center.y());
+        if (method == Gaussian::DrawMethod::INTEGRATE && ky != 0.0) {
+            fy *= std::sin(0.5*ky)/(0.5*ky);
+        }
+        Eigen::Map<Eigen::ArrayXcf> output(row, x.size());
+        Index const offset = x.min() - box.x0();
+        auto const columns = fx.segment(offset, x.size());
+        if (separable) {
+            output += (fy*std::exp(ey)*columns).cast<std::complex<float>>();
+        } else {
+            auto const exponent = ex.segment(offset, x.size()) -
+                covariance(0, 1)*ky*kx.segment(offset, x.size()) + ey;
+            output += (fy*columns*exponent.exp().cast<std::complex<double>>()).cast<std::complex<float>>();
+        }
+    };
+    parallelApplyRows(image, func);
+}
+
+// Implementation of Gaussian::addConvolvedTo and
+// GaussianMixture::addConvolvedTo.
+void addConvolvedImpl(
+    std::vector<Gaussian> const & components,
+    Kernel const & psf,
+    Image<float> const & image,
+    Real nSigma,
+    Gaussian::DrawMethod method
+) {
+    if (psf.upsampling() != 1) {
+        throw std::invalid_argument("Only kernels without upsampling can be applied in Fourier space.");
+    }
+    IndexBox const & box = image.bbox();
+    IndexBox const & taps = psf.image().bbox();
+    // Output pixel x needs the profile at x - j for each kernel pixel j.
+    IndexBox const needed(
+        IndexInterval::fromMinMax(box.x0() - taps.x1(), box.x1() - taps.x0()),
+        IndexInterval::fromMinMax(box.y0() - taps.y1(), box.y1() - taps.y0())
+    );
+    IndexBox footprint;
+    for (auto const & component : components) {
+        footprint.expandTo(component.computeFootprint(nSigma, method));
+    }
+    if (box.isEmpty() || footprint.clippedTo(needed).isEmpty()) {
+        return;
+    }
+    // Sampling the transform makes the profile periodic, so the grid also
+    // covers the profile's footprint to keep the other periods away from the
+    // pixels we need.
+    IndexBox const grid = needed.expandedTo(footprint);
+    Index2 const size(computeFFTSize(grid.width()), computeFFTSize(grid.height()));
+    IndexBox const fftBox = IndexBox::fromMinSize(Index2(0, 0), size);
+    // Draw the transform of the profile, shifted so grid.min() is at the
+    // origin, at signed frequencies, and then move those into FFT order.
+    // The transform of the profile's samples at integer positions is the sum
+    // of its continuous transform over all offsets by multiples of 2pi, so
+    // we add as many of those aliases as each component needs for its
+    // transform to fall below exp(-ALIAS_EXPONENT).
+    Image<std::complex<float>> centered(
+        IndexBox::fromMinSize(Index2(-(size.x()/2), -(size.y()/2)), size)
+    );
+    Real2 const kStep(2*M_PI/size.x(), 2*M_PI/size.y());
+    Translation const shift(Real2(-grid.x0(), -grid.y0()));
+    for (auto const & component : components) {
+        Gaussian const shifted = component.transformedBy(shift);
+        auto const & m = component.transform().matrix();
+        Eigen::Matrix2d const covariance = m*m.transpose();
+        double const minVariance = 0.5*(covariance.trace() - std::sqrt(
+            std::pow(covariance(0, 0) - covariance(1, 1), 2) + 4*covariance(0, 1)*covariance(0, 1)
+        ));
+        // Degenerate components (with zero minimum variance) would need
+        // infinitely many aliases, so we clamp before converting to Index.
+        Index const nAliases = static_cast<Index>(std::min<double>(
+            MAX_ALIASES,
+            std::ceil(0.5*(std::sqrt(2*ALIAS_EXPONENT/std::max(minVariance, 0.0))/M_PI - 1.0))
+        ));
+        for (Index ny = -nAliases; ny <= nAliases; ++ny) {
+            for (Index nx = -nAliases; nx <= nAliases; ++nx) {
+                addKValues(shifted, centered, kStep, Real2(2*M_PI*nx, 2*M_PI*ny), method);
+            }
+        }
+    }
+    auto spectrum = Image<std::complex<float>>::makeUninitialized(fftBox);
+    for (Index y = centered.bbox().y0(); y <= centered.bbox().y1(); ++y) {
+        for (Index x = centered.bbox().x0(); x <= centered.bbox().x1(); ++x) {
+            spectrum[Index2(wrapIndex(x, size.x()), wrapIndex(y, size.y()))] = centered[Index2(x, y)];
+        }
+    }
+    Image<std::complex<float>> kernelSpectrum(fftBox);
+    for (Index y = taps.y0(); y <= taps.y1(); ++y) {
+        for (Index x = taps.x0(); x <= taps.x1(); ++x) {
+            kernelSpectrum[Index2(wrapIndex(x, size.x()), wrapIndex(y, size.y()))] = psf.image()[Index2(x, y)];
+        }
+    }
+    detail::transform2d(kernelSpectrum, false);
+    spectrum.array() *= kernelSpectrum.array();
+    detail::transform2d(spectrum, true);
+    // The transforms are unnormalized.
+    float const scale = 1.0f/(size.x()*size.y());
+    image.array() += scale*spectrum.array(box.shiftedBy(-grid.min())).real();
+}
+
+// Add each of a list of profiles (which may be Gaussians or mixtures) to an
+// image, binning them into tiles as described for renderGaussians.
+template <typename Profile>
+void renderCatalog(
+    std::vector<Profile> const & profiles,
+    Image<float> const & image,
+    Real nSigma,
+    Gaussian::DrawMethod method,
+    Index tileSize
+) {
+    if (tileSize < 1) {
+        throw std::invalid_argument("Tile size must be positive.");
+    }
+    IndexBox const & bbox = image.bbox();
+    if (bbox.isEmpty() || profiles.empty()) {
+        return;
+    }
+    Index const nx = (bbox.width() + tileSize - 1)/tileSize;
+    Index const ny = (bbox.height() + tileSize - 1)/tileSize;
+    // Compute the range of tiles each footprint overlaps (empty if it does
+    // not overlap the image).
+    Index const n = profiles.size();
+    std::vector<IndexBox> ranges(n);
+    detail::parallelFor(
+        (n + FOOTPRINT_CHUNK_SIZE - 1)/FOOTPRINT_CHUNK_SIZE,
+        [&](Index chunk) {
+            Index const end = std::min(n, (chunk + 1)*FOOTPRINT_CHUNK_SIZE);
+            for (Index i = chunk*FOOTPRINT_CHUNK_SIZE; i < end; ++i) {
+                IndexBox const footprint = profiles[i].computeFootprint(nSigma, method).clippedTo(bbox);
+                if (!footprint.isEmpty()) {
+                    ranges[i] = IndexBox(
+                        IndexInterval::fromMinMax((footprint.x0() - bbox.x0())/tileSize,
+                                                  (footprint.x1() - bbox.x0())/tileSize),
+                        IndexInterval::fromMinMax((footprint.y0() - bbox.y0())/tileSize,
+                                                  (footprint.y1() - bbox.y0())/tileSize)
+                    );
+                }
+            }
+        }
+    );
+    // Bin the profiles by tile with a counting sort, which keeps each tile's
+    // profiles in catalog order.
+    std::vector<Index> offsets(nx*ny + 1, 0);
+    for (auto const & range : ranges) {
+        for (Index ty = range.y0(); ty <= range.y1(); ++ty) {
+            for (Index tx = range.x0(); tx <= range.x1(); ++tx) {
+                ++offsets[ty*nx + tx + 1];
+            }
+        }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<Index> members(offsets.back());
+    std::vector<Index> cursors(offsets.begin(), offsets.end() - 1);
+    for (Index i = 0; i < n; ++i) {
+        IndexBox const & range = ranges[i];
+        for (Index ty = range.y0(); ty <= range.y1(); ++ty) {
+            for (Index tx = range.x0(); tx <= range.x1(); ++tx) {
+                members[cursors[ty*nx + tx]++] = i;
+            }
+        }
+    }
+    detail::parallelFor(
+        nx*ny,
+        [&](Index t) {
+            Index const tx = t % nx;
+            Index const ty = t / nx;
+            IndexBox const tile = IndexBox::fromMinSize(
+                Index2(bbox.x0() + tx*tileSize, bbox.y0() + ty*tileSize),
+                Index2(tileSize, tileSize)
+            ).clippedTo(bbox);
+            Image<float> const subimage = image[tile];
+            for (Index k = offsets[t]; k < offsets[t + 1]; ++k) {
+                profiles[members[k]].addTo(subimage, nSigma, method);
+            }
+        }
+    );
+}
+
+
+} // anonymous
+
+constexpr Real Gaussian::DEFAULT_N_SIGMA;
+
 Gaussian::Gaussian(Affine const & transform, double flux) :
     _transform(transform),
     _inv_transform(transform.inverted()),
@@ -19,15 +537,203 @@ double Gaussian::operator()(Real2 const & xy) const {
     return _flux*std::exp(-0.5*z)/(2*M_PI*_transform.det());
 }
 
+std::complex<double> Gaussian::kValue(Real2 const & k) const {
+    // k^T C k, with C the covariance matrix.
+    double const z = (_transform.matrix().transpose()*k.vector()).squaredNorm();
+    return _flux*std::exp(-0.5*z)*std::polar(1.0, -k.vector().dot(_transform.vector()));
+}
+
 Gaussian Gaussian::transformedBy(Affine const & t) const {
     return Gaussian(_transform.then(t), _flux);
 }
 
-void Gaussian::addTo(Image<float> & image) const {
-    auto func = [this](Index2 const & xy, float & pixel) {
-        pixel = (*this)(Real2(xy));
-    };
-    apply(image, func);
+Gaussian Gaussian::convolvedWith(Gaussian const & other) const {
+    Eigen::Matrix2d const covariance = _transform.matrix()*_transform.matrix().transpose() +
+        other._transform.matrix()*other._transform.matrix().transpose();
+    // Use the Cholesky factor of the summed covariance as the new Jacobian.
+    Eigen::Matrix2d jacobian = Eigen::Matrix2d::Zero();
+    jacobian(0, 0) = std::sqrt(covariance(0, 0));
+    jacobian(1, 0) = covariance(1, 0)/jacobian(0, 0);
+    jacobian(1, 1) = std::sqrt(covariance(1, 1) - jacobian(1, 0)*jacobian(1, 0));
+    return Gaussian(
+        Affine(jacobian, _transform.vector() + other._transform.vector()),
+        _flux*other._flux
+    );
+}
+
+RealBox Gaussian::computeBBox(Real nSigma) const {
+    // The ellipse is the image of a circle of radius nSigma, so its extent
+    // along each axis is nSigma times the norm of that row of the Jacobian.
+    auto const & m = _transform.matrix();
+    Real2 const center(_transform.vector());
+    Real2 const half(nSigma*m.row(0).norm(), nSigma*m.row(1).norm());
+    return RealBox(
+        RealInterval::fromMinMax(center.x() - half.x(), center.x() + half.x()),
+        RealInterval::fromMinMax(center.y() - half.y(), center.y() + half.y())
+    );
+}
+
+void Gaussian::addKTo(Image<std::complex<float>> const & image, Real2 const & kStep, DrawMethod method) const {
+    addKValues(*this, image, kStep, Real2(0.0, 0.0), method);
+}
+
+void Gaussian::addConvolvedTo(Kernel const & psf, Image<float> const & image, Real nSigma,
+                              DrawMethod method) const {
+    addConvolvedImpl({*this}, psf, image, nSigma, method);
+}
+
+IndexBox Gaussian::computeFootprint(Real nSigma, DrawMethod method) const {
+    return computeFootprintBox(
+        Real2(_transform.vector()),
+        computeFootprintMatrix(_transform.matrix()*_transform.matrix().transpose(), nSigma, method)
+    );
+}
+
+void Gaussian::addTo(Image<float> const & image, Real nSigma, DrawMethod method) const {
+    GaussianRenderer const renderer(*this, nSigma, method, image.bbox());
+    if (renderer.bbox().isEmpty()) {
+        return;
+    }
+    parallelApplyRows(
+        image[renderer.bbox()],
+        [&renderer](Index y, IndexInterval const & x, float * row) { renderer.addRow(y, x, row); }
+    );
+}
+
+GaussianMixture::GaussianMixture(std::vector<Gaussian> components) :
+    _components(std::move(components))
+{}
+
+double GaussianMixture::operator()(Real2 const & xy) const {
+    double result = 0.0;
+    for (auto const & component : _components) {
+        result += component(xy);
+    }
+    return result;
+}
+
+std::complex<double> GaussianMixture::kValue(Real2 const & k) const {
+    std::complex<double> result = 0.0;
+    for (auto const & component : _components) {
+        result += component.kValue(k);
+    }
+    return result;
+}
+
+double GaussianMixture::flux() const {
+    double result = 0.0;
+    for (auto const & component : _components) {
+        result += component.flux();
+    }
+    return result;
+}
+
+GaussianMixture GaussianMixture::transformedBy(Affine const & t) const {
+    std::vector<Gaussian> result;
+    result.reserve(_components.size());
+    for (auto const & component : _components) {
+        result.push_back(component.transformedBy(t));
+    }
+    return GaussianMixture(std::move(result));
+}
+
+GaussianMixture GaussianMixture::convolvedWith(Gaussian const & psf) const {
+    std::vector<Gaussian> result;
+    result.reserve(_components.size());
+    for (auto const & component : _components) {
+        result.push_back(component.convolvedWith(psf));
+    }
+    return GaussianMixture(std::move(result));
+}
+
+GaussianMixture GaussianMixture::convolvedWith(GaussianMixture const & psf) const {
+    std::vector<Gaussian> result;
+    result.reserve(_components.size()*psf._components.size());
+    for (auto const & component : _components) {
+        for (auto const & psfComponent : psf._components) {
+            result.push_back(component.convolvedWith(psfComponent));
+        }
+    }
+    return GaussianMixture(std::move(result));
+}
+
+IndexBox GaussianMixture::computeFootprint(Real nSigma, Gaussian::DrawMethod method) const {
+    IndexBox result;
+    for (auto const & component : _components) {
+        result.expandTo(component.computeFootprint(nSigma, method));
+    }
+    return result;
+}
+
+void GaussianMixture::addTo(Image<float> const & image, Real nSigma, Gaussian::DrawMethod method) const {
+    std::vector<GaussianRenderer> renderers;
+    renderers.reserve(_components.size());
+    IndexBox box;
+    for (auto const & component : _components) {
+        renderers.emplace_back(component, nSigma, method, image.bbox());
+        box.expandTo(renderers.back().bbox());
+    }
+    if (box.isEmpty()) {
+        return;
+    }
+    parallelApplyRows(
+        image[box],
+        [&renderers](Index y, IndexInterval const & x, float * row) {
+            for (auto const & renderer : renderers) {
+                renderer.addRow(y, x, row);
+            }
+        }
+    );
+}
+
+void GaussianMixture::addKTo(
+    Image<std::complex<float>> const & image,
+    Real2 const & kStep,
+    Gaussian::DrawMethod method
+) const {
+    for (auto const & component : _components) {
+        component.addKTo(image, kStep, method);
+    }
+}
+
+void GaussianMixture::addConvolvedTo(
+    Kernel const & psf,
+    Image<float> const & image,
+    Real nSigma,
+    Gaussian::DrawMethod method
+) const {
+    addConvolvedImpl(_components, psf, image, nSigma, method);
+}
+
+void GaussianMixture::format(detail::Writer & writer, detail::FormatSpec const & spec) const {
+    writer.write("GaussianMixture([");
+    for (std::size_t i = 0; i < _components.size(); ++i) {
+        if (i > 0) {
+            writer.write(", ");
+        }
+        _components[i].format(writer, spec);
+    }
+    writer.write("])");
+}
+
+void renderGaussians(
+    std::vector<Gaussian> const & profiles,
+    Image<float> const & image,
+    Real nSigma,
+    Gaussian::DrawMethod method,
+    Index tileSize
+) {
+    renderCatalog(profiles, image, nSigma, method, tileSize);
+}
+
+void renderGaussians(
+    std::vector<GaussianMixture> const & profiles,
+    Image<float> const & image,
+    Real nSigma,
+    Gaussian::DrawMethod method,
+    Index tileSize
+) {
+    renderCatalog(profiles, image, nSigma, method, tileSize);
 }
 
 void Gaussian::format(detail::Writer & writer, detail::FormatSpec const & spec) const {
@@ -38,4 +744,9 @@ void Gaussian::format(detail::Writer & writer, detail::FormatSpec const & spec)
     );
 }
 
+namespace detail {
+    template class Formattable<Gaussian>;
+    template class Formattable<GaussianMixture>;
+} // namespace detail
+
 } // namespace cipells
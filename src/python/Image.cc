@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 #include "cipells/python.h"
 #include "cipells/python/Image.h"
@@ -16,15 +17,24 @@ namespace cipells {
 
 namespace {
 
+// Return the numpy dtype for a pixel type.
+template <typename T>
+py::dtype getDType() { return py::dtype::of<T>(); }
+
+template <>
+py::dtype getDType<Half>() { return py::dtype("e"); }
+
 // Helper class for extracting a numpy array view from an Image<T>.
 class ImageArrayHelper {
 public:
 
     template <typename T>
     static py::object call(Image<T> const & self) {
+        using Pixel = std::remove_cv_t<T>;
         py::array result(
-            {py::ssize_t(self.bbox().height()), py::ssize_t(self.bbox().width())},
-            {py::ssize_t(self.stride()*sizeof(T)), py::ssize_t(sizeof(T))},
+            getDType<Pixel>(),
+            std::vector<py::ssize_t>{py::ssize_t(self.bbox().height()), py::ssize_t(self.bbox().width())},
+            std::vector<py::ssize_t>{py::ssize_t(self.stride()*sizeof(T)), py::ssize_t(sizeof(T))},
             self.data(),
             manager(self.owner())
         );
@@ -96,18 +106,22 @@ void wrapImage(py::class_<Image<T>, Args...> & cls) {
 class PyImageInitHelper {
 public:
 
-    static PyImage call(IndexBox const & bbox, py::object dtype) {
-        PyImageInitHelper helper(bbox, dtype);
+    static PyImage call(IndexBox const & bbox, py::object dtype, ImageLayout layout) {
+        PyImageInitHelper helper(bbox, dtype, layout);
         if (helper.attempt<float>()) return helper.finish();
         if (helper.attempt<std::complex<float>>()) return helper.finish();
+        if (helper.attempt<double>()) return helper.finish();
+        if (helper.attempt<std::uint16_t>()) return helper.finish();
+        if (helper.attempt<std::int32_t>()) return helper.finish();
+        if (helper.attempt<Half>()) return helper.finish();
         PyErr_SetString(PyExc_TypeError, "dtype not supported");
         throw py::error_already_set();
     }
 
 private:
 
-    PyImageInitHelper(IndexBox const & bbox, py::object dtype) :
-        _bbox(bbox), _dtype(py::dtype::from_args(dtype)),
+    PyImageInitHelper(IndexBox const & bbox, py::object dtype, ImageLayout layout) :
+        _bbox(bbox), _dtype(py::dtype::from_args(dtype)), _layout(layout),
         _wrapped(), _np(py::detail::npy_api::get())
     {}
 
@@ -119,10 +133,10 @@ private:
 
     template <typename T>
     bool attempt() {
-        if (_np.PyArray_EquivTypes_(_dtype.ptr(), py::dtype::of<T>().ptr())) {
+        if (_np.PyArray_EquivTypes_(_dtype.ptr(), getDType<T>().ptr())) {
             _wrapped = py::reinterpret_steal<py::object>(
                 py::detail::type_caster_base<Image<T>>::cast(
-                    Image<T>(_bbox), py::return_value_policy::move, py::handle()
+                    Image<T>(_bbox, _layout), py::return_value_policy::move, py::handle()
                 )
             );
             return true;
@@ -136,21 +150,44 @@ private:
 
     IndexBox _bbox;
     py::dtype _dtype;
+    ImageLayout _layout;
     py::object _wrapped;
     py::detail::npy_api const & _np;
 };
 
 
+// Add wrappers for the private Image<T const> and Image<T> Python APIs.
+template <typename T>
+void wrapImageClasses(utils::Deferrer & helper, py::module & module, char const * constName,
+                      char const * name) {
+    helper.add(
+        py::class_<Image<T const>>(module, constName),
+        [](auto & cls) { wrapImage(cls); }
+    );
+    helper.add(
+        py::class_<Image<T>, Image<T const>>(module, name),
+        [](auto & cls) { wrapImage(cls); }
+    );
+}
+
 } // anonymous
 
 
 utils::Deferrer pyImage(py::module & module) {
     utils::Deferrer helper;
+    helper.add(
+        py::enum_<ImageLayout>(module, "ImageLayout"),
+        [](auto & cls) {
+            cls.value("COMPACT", ImageLayout::COMPACT);
+            cls.value("PADDED", ImageLayout::PADDED);
+        }
+    );
     // Wrappers for PyImage, the public Python face of all Image<T> instantiations.
     helper.add(
         py::class_<PyImage>(module, "Image"),
         [](auto & cls) {
-            cls.def(py::init(&PyImageInitHelper::call), "bbox"_a, "dtype"_a);
+            cls.def(py::init(&PyImageInitHelper::call), "bbox"_a, "dtype"_a,
+                    "layout"_a=ImageLayout::COMPACT);
             cls.def_property(
                 "array",
                 [](PyImage & self) -> py::object {
@@ -217,6 +254,10 @@ utils::Deferrer pyImage(py::module & module) {
         ),
         [](auto & cls) { wrapImage(cls); }
     );
+    wrapImageClasses<double>(helper, module, "_ImageDoubleConst", "_ImageDouble");
+    wrapImageClasses<std::uint16_t>(helper, module, "_ImageUInt16Const", "_ImageUInt16");
+    wrapImageClasses<std::int32_t>(helper, module, "_ImageInt32Const", "_ImageInt32");
+    wrapImageClasses<Half>(helper, module, "_ImageHalfConst", "_ImageHalf");
     return helper;
 }
 
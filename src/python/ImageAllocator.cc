@@ -0,0 +1,40 @@
+#include "pybind11/pybind11.h"
+
+#include "cipells/python.h"
+#include "cipells/ImageAllocator.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace cipells {
+
+utils::Deferrer pyImageAllocator(py::module & module) {
+    utils::Deferrer helper;
+    helper.add(
+        py::class_<ImageAllocationStats>(module, "ImageAllocationStats"),
+        [](auto & cls) {
+            cls.def_readonly("allocations", &ImageAllocationStats::allocations);
+            cls.def_readonly("reused", &ImageAllocationStats::reused);
+            cls.def_readonly("bytesInUse", &ImageAllocationStats::bytesInUse);
+            cls.def_readonly("bytesCached", &ImageAllocationStats::bytesCached);
+        }
+    );
+    helper.add(
+        py::class_<ImageAllocator, std::shared_ptr<ImageAllocator>>(module, "ImageAllocator"),
+        [](auto & cls) {
+            cls.def_static("makeHeap", &ImageAllocator::makeHeap);
+            cls.def_static("makePool", &ImageAllocator::makePool, "maxCachedBytes"_a=(std::size_t(1) << 30));
+            cls.def_property_readonly("stats", &ImageAllocator::stats);
+            cls.def("trim", &ImageAllocator::trim);
+        }
+    );
+    helper.add(
+        [&module]() {
+            module.def("setImageAllocator", &setImageAllocator, "allocator"_a);
+            module.def("getImageAllocator", &getImageAllocator);
+        }
+    );
+    return helper;
+}
+
+} // namespace cipells
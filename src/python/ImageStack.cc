@@ -0,0 +1,101 @@
+#include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
+
+#include <vector>
+
+#include "cipells/python.h"
+#include "cipells/ImageStack.h"
+#include "fmt/format.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace cipells {
+
+namespace {
+
+void deleteOwner(void * p) {
+    delete reinterpret_cast<ImageOwner*>(p);
+}
+
+// Return a writeable numpy view of all of the stack's pixels, with shape
+// (planes, height, width) regardless of the stack's layout.
+py::array makeStackArray(ImageStack<float> const & self) {
+    return py::array(
+        py::dtype::of<float>(),
+        std::vector<py::ssize_t>{
+            py::ssize_t(self.planeCount()), py::ssize_t(self.bbox().height()), py::ssize_t(self.bbox().width())
+        },
+        std::vector<py::ssize_t>{
+            py::ssize_t(self.planeStride()*sizeof(float)),
+            py::ssize_t(self.rowStride()*sizeof(float)),
+            py::ssize_t(self.pixelStride()*sizeof(float))
+        },
+        self.data(),
+        py::capsule(new ImageOwner(self.owner()), &deleteOwner)
+    );
+}
+
+} // anonymous
+
+utils::Deferrer pyImageStack(py::module & module) {
+    utils::Deferrer helper;
+    helper.add(
+        py::enum_<StackLayout>(module, "StackLayout"),
+        [](auto & cls) {
+            cls.value("PLANAR", StackLayout::PLANAR);
+            cls.value("INTERLEAVED", StackLayout::INTERLEAVED);
+        }
+    );
+    // Only float stacks are exposed to Python, since only they can be warped
+    // and convolved.
+    helper.add(
+        py::class_<ImageStack<float>>(module, "ImageStack"),
+        [](auto & cls) {
+            cls.def(py::init<IndexBox const &, Index, StackLayout>(), "bbox"_a, "planeCount"_a,
+                    "layout"_a=StackLayout::PLANAR);
+            cls.def(
+                "__getitem__",
+                [](ImageStack<float> const & self, IndexBox const & box) {
+                    if (!self.bbox().contains(box)) {
+                        throw py::index_error(fmt::format("Subimage bbox {} out of range for stack with bbox {}",
+                                                          box, self.bbox()));
+                    }
+                    return self[box];
+                }
+            );
+            cls.def(
+                "copyPlane",
+                [](ImageStack<float> const & self, Index plane) {
+                    if (plane < 0 || plane >= self.planeCount()) {
+                        throw py::index_error(fmt::format("Plane {} out of range for stack with {} planes",
+                                                          plane, self.planeCount()));
+                    }
+                    return self.copyPlane(plane);
+                },
+                "plane"_a
+            );
+            cls.def(
+                "setPlane",
+                [](ImageStack<float> const & self, Index plane, Image<float const> const & image) {
+                    if (plane < 0 || plane >= self.planeCount()) {
+                        throw py::index_error(fmt::format("Plane {} out of range for stack with {} planes",
+                                                          plane, self.planeCount()));
+                    }
+                    self.setPlane(plane, image);
+                },
+                "plane"_a, "image"_a
+            );
+            cls.def_property_readonly(
+                "bbox",
+                [](ImageStack<float> const & self) -> IndexBox { return self.bbox(); }
+            );
+            cls.def_property_readonly("planeCount", &ImageStack<float>::planeCount);
+            cls.def_property_readonly("layout", &ImageStack<float>::layout);
+            cls.def_property_readonly("array", &makeStackArray);
+        }
+    );
+    return helper;
+}
+
+} // namespace cipells
@@ -18,7 +18,80 @@ utils::Deferrer pyInterpolant(py::module & module) {
             cls.def_property_readonly_static("sinc", [](py::object) { return Interpolant::sinc(); });
             cls.def_property_readonly_static("cubic", [](py::object) { return Interpolant::cubic(); });
             cls.def_property_readonly_static("quintic", [](py::object) { return Interpolant::quintic(); });
+            cls.def_static("lanczos", &Interpolant::lanczos, "order"_a);
+            cls.def_static("tabulate", &Interpolant::tabulate, "exact"_a, "phases"_a=1024, "blend"_a=false);
+            cls.def_property_readonly("radius", &Interpolant::radius);
+            cls.def_property_readonly("maxError", &Interpolant::maxError);
             cls.def("__call__", py::vectorize(&Interpolant::operator()));
+            cls.def(
+                "evaluate",
+                [](Interpolant const & self, py::array_t<float, py::array::c_style | py::array::forcecast> x) {
+                    py::array_t<float> result(x.request().shape);
+                    Index size = static_cast<Index>(x.size());
+                    self.evaluate(
+                        Eigen::Map<Eigen::ArrayXf const>(x.data(), size),
+                        Eigen::Map<Eigen::ArrayXf>(result.mutable_data(), size)
+                    );
+                    return result;
+                },
+                "x"_a
+            );
+            cls.def(
+                "warp",
+                py::overload_cast<Image<float const> const &, Affine const &, Image<float> const &>(
+                    &Interpolant::warp, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a
+            );
+            cls.def(
+                "warp",
+                py::overload_cast<ImageStack<float> const &, Affine const &, ImageStack<float> const &>(
+                    &Interpolant::warp, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a
+            );
+            cls.def(
+                "warp",
+                py::overload_cast<MaskedImage const &, Affine const &, MaskedImage const &>(
+                    &Interpolant::warp, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a
+            );
+            cls.def(
+                "warp",
+                py::overload_cast<Image<std::uint16_t const> const &, Affine const &, Image<float> const &>(
+                    &Interpolant::warp, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a
+            );
+            cls.def(
+                "warp",
+                py::overload_cast<Image<Half const> const &, Affine const &, Image<float> const &>(
+                    &Interpolant::warp, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a
+            );
+            cls.def(
+                "warpDirect",
+                py::overload_cast<Image<float const> const &, Affine const &, Image<float> const &>(
+                    &Interpolant::warpDirect, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a
+            );
+            cls.def(
+                "warpDirect",
+                py::overload_cast<ImageStack<float> const &, Affine const &, ImageStack<float> const &>(
+                    &Interpolant::warpDirect, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a
+            );
+            cls.def(
+                "warpDirect",
+                py::overload_cast<MaskedImage const &, Affine const &, MaskedImage const &>(
+                    &Interpolant::warpDirect, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a
+            );
         }
     );
     return helper;
@@ -14,6 +14,11 @@ utils::Deferrer pyKernel(py::module & module) {
     helper.add(
         py::class_<Kernel>(module, "Kernel"),
         [](auto & cls) {
+            py::enum_<Kernel::ConvolutionMode>(cls, "ConvolutionMode")
+                .value("AUTO", Kernel::ConvolutionMode::AUTO)
+                .value("DIRECT", Kernel::ConvolutionMode::DIRECT)
+                .value("FFT", Kernel::ConvolutionMode::FFT)
+                .value("SEPARABLE", Kernel::ConvolutionMode::SEPARABLE);
             cls.def(py::init<Image<float const> const &, Index, std::shared_ptr<Interpolant const>>(),
                     "image"_a, "upsampling"_a=1, "interpolant"_a=nullptr);
             cls.def_property_readonly("image", &Kernel::image);
@@ -22,6 +27,104 @@ utils::Deferrer pyKernel(py::module & module) {
             cls.def("resample", &Kernel::resample, "upsampling"_a, "interpolant"_a=nullptr);
             cls.def("warp", &Kernel::warp, "transform"_a, "bbox"_a, "upsampling"_a=1,
                     "interpolant"_a=nullptr);
+            cls.def("decompose", &Kernel::decompose, "tolerance"_a);
+            cls.def_property_readonly("separableRank", &Kernel::separableRank);
+            cls.def_property_readonly("separableResidual", &Kernel::separableResidual);
+            cls.def("chooseConvolutionMode", &Kernel::chooseConvolutionMode);
+            cls.def(
+                "convolve",
+                py::overload_cast<Image<float const> const &, Affine const &, Image<float> const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::convolve, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "convolve",
+                py::overload_cast<Image<float const> const &, Affine const &, Kernel::ConvolutionMode>(
+                    &Kernel::convolve, py::const_
+                ),
+                "input"_a, "transform"_a=Affine(), "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "convolve",
+                py::overload_cast<ImageStack<float> const &, Affine const &, ImageStack<float> const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::convolve, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "convolve",
+                py::overload_cast<MaskedImage const &, Affine const &, MaskedImage const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::convolve, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "convolve",
+                py::overload_cast<Image<std::uint16_t const> const &, Affine const &, Image<float> const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::convolve, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "convolve",
+                py::overload_cast<Image<Half const> const &, Affine const &, Image<float> const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::convolve, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "correlate",
+                py::overload_cast<Image<float const> const &, Affine const &, Image<float> const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::correlate, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "correlate",
+                py::overload_cast<ImageStack<float> const &, Affine const &, ImageStack<float> const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::correlate, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "correlate",
+                py::overload_cast<MaskedImage const &, Affine const &, MaskedImage const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::correlate, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "correlate",
+                py::overload_cast<Image<std::uint16_t const> const &, Affine const &, Image<float> const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::correlate, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "correlate",
+                py::overload_cast<Image<Half const> const &, Affine const &, Image<float> const &,
+                                  Kernel::ConvolutionMode>(
+                    &Kernel::correlate, py::const_
+                ),
+                "input"_a, "transform"_a, "output"_a, "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
+            cls.def(
+                "correlate",
+                py::overload_cast<Image<float const> const &, Affine const &, Kernel::ConvolutionMode>(
+                    &Kernel::correlate, py::const_
+                ),
+                "input"_a, "transform"_a=Affine(), "mode"_a=Kernel::ConvolutionMode::AUTO
+            );
         }
     );
     return helper;
@@ -0,0 +1,109 @@
+#include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
+
+#include "cipells/python.h"
+#include "cipells/MappedFile.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace cipells {
+
+namespace {
+
+bool matches(py::dtype const & dtype, py::dtype const & target) {
+    return py::detail::npy_api::get().PyArray_EquivTypes_(dtype.ptr(), target.ptr());
+}
+
+py::object createImageFileForDType(std::string const & path, IndexBox const & bbox, py::object dtype,
+                                   ImageLayout layout) {
+    py::dtype resolved = py::dtype::from_args(dtype);
+    if (matches(resolved, py::dtype::of<float>())) {
+        return py::cast(createImageFile<float>(path, bbox, layout));
+    }
+    if (matches(resolved, py::dtype::of<std::complex<float>>())) {
+        return py::cast(createImageFile<std::complex<float>>(path, bbox, layout));
+    }
+    if (matches(resolved, py::dtype::of<double>())) {
+        return py::cast(createImageFile<double>(path, bbox, layout));
+    }
+    if (matches(resolved, py::dtype::of<std::uint16_t>())) {
+        return py::cast(createImageFile<std::uint16_t>(path, bbox, layout));
+    }
+    if (matches(resolved, py::dtype::of<std::int32_t>())) {
+        return py::cast(createImageFile<std::int32_t>(path, bbox, layout));
+    }
+    if (matches(resolved, py::dtype("e"))) {
+        return py::cast(createImageFile<Half>(path, bbox, layout));
+    }
+    PyErr_SetString(PyExc_TypeError, "dtype not supported");
+    throw py::error_already_set();
+}
+
+template <typename T>
+py::object openImageFileFor(std::string const & path, bool writable) {
+    if (writable) {
+        return py::cast(openWritableImageFile<T>(path));
+    }
+    return py::cast(openImageFile<T>(path));
+}
+
+} // anonymous
+
+
+utils::Deferrer pyMappedFile(py::module & module) {
+    utils::Deferrer helper;
+    helper.add(
+        py::enum_<PixelType>(module, "PixelType"),
+        [](auto & cls) {
+            cls.value("FLOAT32", PixelType::FLOAT32);
+            cls.value("COMPLEX64", PixelType::COMPLEX64);
+            cls.value("FLOAT64", PixelType::FLOAT64);
+            cls.value("UINT16", PixelType::UINT16);
+            cls.value("INT32", PixelType::INT32);
+            cls.value("FLOAT16", PixelType::FLOAT16);
+        }
+    );
+    helper.add(
+        py::enum_<MapAdvice>(module, "MapAdvice"),
+        [](auto & cls) {
+            cls.value("NORMAL", MapAdvice::NORMAL);
+            cls.value("SEQUENTIAL", MapAdvice::SEQUENTIAL);
+            cls.value("RANDOM", MapAdvice::RANDOM);
+            cls.value("WILLNEED", MapAdvice::WILLNEED);
+        }
+    );
+    helper.add(
+        [&module]() {
+            module.def("createImageFile", &createImageFileForDType, "path"_a, "bbox"_a, "dtype"_a,
+                       "layout"_a=ImageLayout::COMPACT);
+            module.def(
+                "openImageFile",
+                [](std::string const & path, bool writable) -> py::object {
+                    switch (readImageFilePixelType(path)) {
+                    case PixelType::FLOAT32:
+                        return openImageFileFor<float>(path, writable);
+                    case PixelType::COMPLEX64:
+                        return openImageFileFor<std::complex<float>>(path, writable);
+                    case PixelType::FLOAT64:
+                        return openImageFileFor<double>(path, writable);
+                    case PixelType::UINT16:
+                        return openImageFileFor<std::uint16_t>(path, writable);
+                    case PixelType::INT32:
+                        return openImageFileFor<std::int32_t>(path, writable);
+                    case PixelType::FLOAT16:
+                        return openImageFileFor<Half>(path, writable);
+                    }
+                    throw std::runtime_error("Image file '" + path + "' has an unknown pixel type.");
+                },
+                "path"_a, "writable"_a=false
+            );
+            module.def("readImageFilePixelType", &readImageFilePixelType, "path"_a);
+            module.def("advise", &advise<float>, "image"_a, "advice"_a);
+            module.def("advise", &advise<std::complex<float>>, "image"_a, "advice"_a);
+        }
+    );
+    return helper;
+}
+
+} // namespace cipells
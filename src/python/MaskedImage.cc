@@ -0,0 +1,42 @@
+#include "pybind11/pybind11.h"
+
+#include "cipells/python.h"
+#include "cipells/MaskedImage.h"
+#include "fmt/format.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace cipells {
+
+utils::Deferrer pyMaskedImage(py::module & module) {
+    utils::Deferrer helper;
+    helper.add(
+        py::class_<MaskedImage>(module, "MaskedImage"),
+        [](auto & cls) {
+            cls.def(py::init<IndexBox const &, ImageLayout>(), "bbox"_a, "layout"_a=ImageLayout::COMPACT);
+            cls.def(py::init<Image<float>, Image<MaskPixel>, Image<float>>(), "image"_a, "mask"_a, "variance"_a);
+            cls.def(
+                "__getitem__",
+                [](MaskedImage const & self, IndexBox const & box) {
+                    if (!self.bbox().contains(box)) {
+                        throw py::index_error(fmt::format("Subimage bbox {} out of range for image with bbox {}",
+                                                          box, self.bbox()));
+                    }
+                    return self[box];
+                }
+            );
+            cls.def("copy", &MaskedImage::copy);
+            cls.def_property_readonly(
+                "bbox",
+                [](MaskedImage const & self) -> IndexBox { return self.bbox(); }
+            );
+            cls.def_property_readonly("image", [](MaskedImage const & self) { return self.image(); });
+            cls.def_property_readonly("mask", [](MaskedImage const & self) { return self.mask(); });
+            cls.def_property_readonly("variance", [](MaskedImage const & self) { return self.variance(); });
+        }
+    );
+    return helper;
+}
+
+} // namespace cipells
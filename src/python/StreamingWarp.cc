@@ -0,0 +1,40 @@
+#include "pybind11/pybind11.h"
+
+#include "cipells/python.h"
+#include "cipells/StreamingWarp.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace cipells {
+
+utils::Deferrer pyStreamingWarp(py::module & module) {
+    utils::Deferrer helper;
+    helper.add(
+        py::class_<StreamingWarp>(module, "StreamingWarp"),
+        [](auto & cls) {
+            cls.def(
+                py::init(
+                    [](std::shared_ptr<Interpolant const> interpolant, IndexBox const & inputBBox,
+                       Affine const & transform, IndexBox const & outputBBox, py::function sink) {
+                        // Rows are copied, since Python callables may hold on
+                        // to them after returning.
+                        return new StreamingWarp(
+                            std::move(interpolant), inputBBox, transform, outputBBox,
+                            [sink](Image<float const> const & row) { sink(row.copy()); }
+                        );
+                    }
+                ),
+                "interpolant"_a, "inputBBox"_a, "transform"_a, "outputBBox"_a, "sink"_a
+            );
+            cls.def("push", &StreamingWarp::push, "rows"_a);
+            cls.def("finish", &StreamingWarp::finish);
+            cls.def_property_readonly("bufferHeight", &StreamingWarp::bufferHeight);
+            cls.def_property_readonly("nextInputRow", &StreamingWarp::nextInputRow);
+            cls.def_property_readonly("nextOutputRow", &StreamingWarp::nextOutputRow);
+        }
+    );
+    return helper;
+}
+
+} // namespace cipells
@@ -0,0 +1,56 @@
+#include "pybind11/pybind11.h"
+
+#include "cipells/python.h"
+#include "cipells/TiledImage.h"
+#include "cipells/Interpolant.h"
+#include "cipells/Kernel.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace cipells {
+
+utils::Deferrer pyTiledImage(py::module & module) {
+    utils::Deferrer helper;
+    helper.add(
+        py::class_<TileCacheStats>(module, "TileCacheStats"),
+        [](auto & cls) {
+            cls.def_readonly("hits", &TileCacheStats::hits);
+            cls.def_readonly("misses", &TileCacheStats::misses);
+            cls.def_readonly("writes", &TileCacheStats::writes);
+            cls.def_readonly("bytesCached", &TileCacheStats::bytesCached);
+        }
+    );
+    // Only float tiled images are exposed to Python, since only they can be
+    // warped and convolved.
+    helper.add(
+        py::class_<TiledImage<float>>(module, "TiledImage"),
+        [](auto & cls) {
+            cls.def_static("create", &TiledImage<float>::create, "path"_a, "bbox"_a, "tileSize"_a=256,
+                           "maxCachedBytes"_a=(std::size_t(1) << 28));
+            cls.def_static("open", &TiledImage<float>::open, "path"_a, "writable"_a=false,
+                           "maxCachedBytes"_a=(std::size_t(1) << 28));
+            cls.def_property_readonly(
+                "bbox",
+                [](TiledImage<float> const & self) -> IndexBox { return self.bbox(); }
+            );
+            cls.def_property_readonly("tileSize", &TiledImage<float>::tileSize);
+            cls.def_property_readonly("isWritable", &TiledImage<float>::isWritable);
+            cls.def("getTileBBox", &TiledImage<float>::getTileBBox, "index"_a);
+            cls.def("read", &TiledImage<float>::read, "box"_a);
+            cls.def("write", &TiledImage<float>::write, "image"_a);
+            cls.def("flush", &TiledImage<float>::flush);
+            cls.def_property_readonly("stats", &TiledImage<float>::stats);
+        }
+    );
+    helper.add(
+        [&module]() {
+            module.def("warp", &warp, "interpolant"_a, "input"_a, "transform"_a, "output"_a);
+            module.def("convolve", &convolve, "kernel"_a, "input"_a, "transform"_a, "output"_a,
+                       "transpose"_a=false);
+        }
+    );
+    return helper;
+}
+
+} // namespace cipells
@@ -6,7 +6,15 @@ PYBIND11_MODULE(_cipells, m) {
     auto pyBox = cipells::pyBox(m);
     auto pyTransforms = cipells::pyTransforms(m);
     auto pyImage = cipells::pyImage(m);
+    auto pyImageStack = cipells::pyImageStack(m);
+    auto pyMaskedImage = cipells::pyMaskedImage(m);
+    auto pyImageAllocator = cipells::pyImageAllocator(m);
     auto pyInterpolant = cipells::pyInterpolant(m);
     auto pyKernel = cipells::pyKernel(m);
+    auto pyMappedFile = cipells::pyMappedFile(m);
+    auto pyTiledImage = cipells::pyTiledImage(m);
+    auto pyStreamingWarp = cipells::pyStreamingWarp(m);
+    auto pyStatistics = cipells::pyStatistics(m);
     auto pyProfiles = cipells::pyProfiles(m);
+    auto pyParallel = cipells::pyParallel(m);
 }
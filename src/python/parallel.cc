@@ -0,0 +1,22 @@
+#include "pybind11/pybind11.h"
+
+#include "cipells/python.h"
+#include "cipells/parallel.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace cipells {
+
+utils::Deferrer pyParallel(py::module & module) {
+    utils::Deferrer helper;
+    helper.add(
+        [&module]() {
+            module.def("setThreadCount", &setThreadCount, "n"_a);
+            module.def("getThreadCount", &getThreadCount);
+        }
+    );
+    return helper;
+}
+
+} // namespace cipells
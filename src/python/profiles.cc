@@ -1,19 +1,50 @@
 #include "pybind11/pybind11.h"
 #include "pybind11/numpy.h"
+#include "pybind11/stl.h"
 
 #include "cipells/python.h"
 #include "cipells/profiles.h"
+#include "cipells/Kernel.h"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
 
 namespace cipells {
 
+namespace {
+
+using RealArray = py::array_t<Real, py::array::c_style | py::array::forcecast>;
+
+// Build a catalog of Gaussians from arrays of Jacobian matrices with shape
+// (n, 2, 2), centers with shape (n, 2), and fluxes with shape (n,).
+std::vector<Gaussian> makeCatalog(RealArray matrices, RealArray centers, RealArray fluxes) {
+    auto m = matrices.unchecked<3>();
+    auto c = centers.unchecked<2>();
+    auto f = fluxes.unchecked<1>();
+    if (m.shape(1) != 2 || m.shape(2) != 2 || c.shape(1) != 2 ||
+            c.shape(0) != m.shape(0) || f.shape(0) != m.shape(0)) {
+        throw std::invalid_argument("Inconsistent shapes for catalog arrays.");
+    }
+    std::vector<Gaussian> result;
+    result.reserve(m.shape(0));
+    for (ssize_t i = 0; i < m.shape(0); ++i) {
+        Matrix2<Real> matrix;
+        matrix << m(i, 0, 0), m(i, 0, 1), m(i, 1, 0), m(i, 1, 1);
+        result.emplace_back(Affine(matrix, Vector2<Real>(c(i, 0), c(i, 1))), f(i));
+    }
+    return result;
+}
+
+} // anonymous
+
 utils::Deferrer pyProfiles(py::module & module) {
     utils::Deferrer helper;
     helper.add(
         py::class_<Gaussian>(module, "Gaussian"),
         [](auto & cls) {
+            py::enum_<Gaussian::DrawMethod>(cls, "DrawMethod")
+                .value("SAMPLE", Gaussian::DrawMethod::SAMPLE)
+                .value("INTEGRATE", Gaussian::DrawMethod::INTEGRATE);
             cls.def(py::init<Affine const &, Real>(), "transform"_a, "flux"_a=1);
             cls.def("__call__", py::overload_cast<Real2 const &>(&Gaussian::operator(), py::const_));
             cls.def(
@@ -21,10 +52,97 @@ utils::Deferrer pyProfiles(py::module & module) {
                 py::vectorize(py::overload_cast<Real, Real>(&Gaussian::operator(), py::const_)),
                 "x"_a, "y"_a
             );
+            cls.def("kValue", py::overload_cast<Real2 const &>(&Gaussian::kValue, py::const_), "k"_a);
+            cls.def(
+                "kValue",
+                py::vectorize(py::overload_cast<Real, Real>(&Gaussian::kValue, py::const_)),
+                "kx"_a, "ky"_a
+            );
             cls.def(
                 "transformedBy",
                 &Gaussian::transformedBy
             );
+            cls.attr("DEFAULT_N_SIGMA") = Gaussian::DEFAULT_N_SIGMA;
+            cls.def("computeBBox", &Gaussian::computeBBox, "nSigma"_a=Gaussian::DEFAULT_N_SIGMA);
+            cls.def_property_readonly("transform", &Gaussian::transform, py::return_value_policy::copy);
+            cls.def_property_readonly("flux", &Gaussian::flux);
+            cls.def("convolvedWith", &Gaussian::convolvedWith, "other"_a);
+            cls.def("computeFootprint", &Gaussian::computeFootprint,
+                    "nSigma"_a=Gaussian::DEFAULT_N_SIGMA, "method"_a=Gaussian::DrawMethod::SAMPLE);
+            cls.def(
+                "addTo", &Gaussian::addTo,
+                "image"_a, "nSigma"_a=Gaussian::DEFAULT_N_SIGMA, "method"_a=Gaussian::DrawMethod::SAMPLE
+            );
+            cls.def("addKTo", &Gaussian::addKTo,
+                    "image"_a, "kStep"_a, "method"_a=Gaussian::DrawMethod::SAMPLE);
+            cls.def(
+                "addConvolvedTo", &Gaussian::addConvolvedTo,
+                "psf"_a, "image"_a, "nSigma"_a=Gaussian::DEFAULT_N_SIGMA,
+                "method"_a=Gaussian::DrawMethod::SAMPLE
+            );
+        }
+    );
+    helper.add(
+        py::class_<GaussianMixture>(module, "GaussianMixture"),
+        [](auto & cls) {
+            cls.def(py::init<std::vector<Gaussian>>(), "components"_a);
+            cls.def("__call__", py::overload_cast<Real2 const &>(&GaussianMixture::operator(), py::const_));
+            cls.def(
+                "__call__",
+                py::vectorize(py::overload_cast<Real, Real>(&GaussianMixture::operator(), py::const_)),
+                "x"_a, "y"_a
+            );
+            cls.def("kValue", py::overload_cast<Real2 const &>(&GaussianMixture::kValue, py::const_), "k"_a);
+            cls.def(
+                "kValue",
+                py::vectorize(py::overload_cast<Real, Real>(&GaussianMixture::kValue, py::const_)),
+                "kx"_a, "ky"_a
+            );
+            cls.def_property_readonly("components", &GaussianMixture::components);
+            cls.def_property_readonly("flux", &GaussianMixture::flux);
+            cls.def("transformedBy", &GaussianMixture::transformedBy);
+            cls.def("convolvedWith",
+                    py::overload_cast<Gaussian const &>(&GaussianMixture::convolvedWith, py::const_),
+                    "psf"_a);
+            cls.def("convolvedWith",
+                    py::overload_cast<GaussianMixture const &>(&GaussianMixture::convolvedWith, py::const_),
+                    "psf"_a);
+            cls.def("computeFootprint", &GaussianMixture::computeFootprint,
+                    "nSigma"_a=Gaussian::DEFAULT_N_SIGMA, "method"_a=Gaussian::DrawMethod::SAMPLE);
+            cls.def(
+                "addTo", &GaussianMixture::addTo,
+                "image"_a, "nSigma"_a=Gaussian::DEFAULT_N_SIGMA, "method"_a=Gaussian::DrawMethod::SAMPLE
+            );
+            cls.def("addKTo", &GaussianMixture::addKTo,
+                    "image"_a, "kStep"_a, "method"_a=Gaussian::DrawMethod::SAMPLE);
+            cls.def(
+                "addConvolvedTo", &GaussianMixture::addConvolvedTo,
+                "psf"_a, "image"_a, "nSigma"_a=Gaussian::DEFAULT_N_SIGMA,
+                "method"_a=Gaussian::DrawMethod::SAMPLE
+            );
+        }
+    );
+    helper.add(
+        [&module]() {
+            module.def("renderGaussians",
+                       py::overload_cast<std::vector<Gaussian> const &, Image<float> const &, Real,
+                                         Gaussian::DrawMethod, Index>(&renderGaussians),
+                       "profiles"_a, "image"_a, "nSigma"_a=Gaussian::DEFAULT_N_SIGMA,
+                       "method"_a=Gaussian::DrawMethod::SAMPLE, "tileSize"_a=RENDER_TILE_SIZE);
+            module.def("renderGaussians",
+                       py::overload_cast<std::vector<GaussianMixture> const &, Image<float> const &, Real,
+                                         Gaussian::DrawMethod, Index>(&renderGaussians),
+                       "profiles"_a, "image"_a, "nSigma"_a=Gaussian::DEFAULT_N_SIGMA,
+                       "method"_a=Gaussian::DrawMethod::SAMPLE, "tileSize"_a=RENDER_TILE_SIZE);
+            module.def(
+                "renderGaussians",
+                [](RealArray matrices, RealArray centers, RealArray fluxes, Image<float> const & image,
+                   Real nSigma, Gaussian::DrawMethod method, Index tileSize) {
+                    renderGaussians(makeCatalog(matrices, centers, fluxes), image, nSigma, method, tileSize);
+                },
+                "matrices"_a, "centers"_a, "fluxes"_a, "image"_a, "nSigma"_a=Gaussian::DEFAULT_N_SIGMA,
+                "method"_a=Gaussian::DrawMethod::SAMPLE, "tileSize"_a=RENDER_TILE_SIZE
+            );
         }
     );
     return helper;
@@ -0,0 +1,81 @@
+#include "pybind11/pybind11.h"
+#include "pybind11/eigen.h"
+#include "pybind11/stl.h"
+
+#include "cipells/python.h"
+#include "cipells/statistics.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace cipells {
+
+namespace {
+
+template <typename T>
+void wrapStatistics(py::module & module) {
+    module.def("computeStatistics", py::overload_cast<Image<T const> const &>(&computeStatistics<T>),
+               "image"_a);
+    module.def("computeStatistics",
+               py::overload_cast<std::vector<Image<T const>> const &>(&computeStatistics<T>),
+               "images"_a);
+    module.def("computeMoments", py::overload_cast<Image<T const> const &>(&computeMoments<T>),
+               "image"_a);
+    module.def("computeMoments",
+               py::overload_cast<std::vector<Image<T const>> const &>(&computeMoments<T>),
+               "images"_a);
+    module.def("computeClippedStatistics",
+               py::overload_cast<Image<T const> const &, double, int>(&computeClippedStatistics<T>),
+               "image"_a, "nSigma"_a=3.0, "maxIterations"_a=5);
+    module.def("computeClippedStatistics",
+               py::overload_cast<std::vector<Image<T const>> const &, double, int>(
+                   &computeClippedStatistics<T>
+               ),
+               "images"_a, "nSigma"_a=3.0, "maxIterations"_a=5);
+}
+
+} // anonymous
+
+utils::Deferrer pyStatistics(py::module & module) {
+    utils::Deferrer helper;
+    helper.add(
+        py::class_<ImageStatistics>(module, "ImageStatistics"),
+        [](auto & cls) {
+            cls.def_readonly("count", &ImageStatistics::count);
+            cls.def_readonly("sum", &ImageStatistics::sum);
+            cls.def_readonly("mean", &ImageStatistics::mean);
+            cls.def_readonly("variance", &ImageStatistics::variance);
+            cls.def_readonly("min", &ImageStatistics::min);
+            cls.def_readonly("max", &ImageStatistics::max);
+        }
+    );
+    helper.add(
+        py::class_<ImageMoments>(module, "ImageMoments"),
+        [](auto & cls) {
+            cls.def_readonly("flux", &ImageMoments::flux);
+            cls.def_readonly("centroid", &ImageMoments::centroid);
+            cls.def_readonly("secondMoments", &ImageMoments::secondMoments);
+        }
+    );
+    helper.add(
+        py::class_<ClippedStatistics>(module, "ClippedStatistics"),
+        [](auto & cls) {
+            cls.def_readonly("count", &ClippedStatistics::count);
+            cls.def_readonly("mean", &ClippedStatistics::mean);
+            cls.def_readonly("stddev", &ClippedStatistics::stddev);
+            cls.def_readonly("iterations", &ClippedStatistics::iterations);
+        }
+    );
+    helper.add(
+        [&module]() {
+            wrapStatistics<float>(module);
+            wrapStatistics<double>(module);
+            wrapStatistics<std::uint16_t>(module);
+            wrapStatistics<std::int32_t>(module);
+            wrapStatistics<Half>(module);
+        }
+    );
+    return helper;
+}
+
+} // namespace cipells
@@ -3,6 +3,7 @@
 #include "fmt/format.h"
 
 #include "cipells/Image.h"
+#include "cipells/ImageExpression.h"
 #include "cipells/transforms.h"
 
 namespace py = pybind11;
@@ -73,6 +74,41 @@ void wrapImageHelpers(py::module & m) {
     m.def("testImageFreeze2", &testImageFreeze2<T>);
 }
 
+// Apply a detector calibration chain as a single lazy image expression.
+Image<float> calibrateImage(
+    Image<std::uint16_t const> const & raw,
+    Image<float const> const & bias,
+    Image<float const> const & flat,
+    float gain
+) {
+    return evaluate((cast<float>(raw) - bias)*gain/flat);
+}
+
+// As calibrateImage, but write into (part of) an existing image.
+void calibrateImageInto(
+    Image<float> const & output,
+    Image<std::uint16_t const> const & raw,
+    Image<float const> const & bias,
+    Image<float const> const & flat,
+    float gain
+) {
+    assign(output, (cast<float>(raw) - bias)*gain/flat);
+}
+
+// Multiply images by a scalar on either side, leaving the pixel type of the
+// result to the expression (see ImageExpression), so tests can check it.
+auto scaleRawImage(Image<std::uint16_t const> const & raw, double factor) {
+    return evaluate(raw*factor);
+}
+
+auto scaleRawImageLeft(Image<std::uint16_t const> const & raw, double factor) {
+    return evaluate(factor*raw);
+}
+
+auto scaleFloatImage(Image<float const> const & image, double factor) {
+    return evaluate(image*factor);
+}
+
 bool acceptJacobian(Jacobian const & jacobian) { return true; }
 bool acceptTranslation(Translation const & translation) { return true; }
 bool acceptAffine(Affine const & affine) { return true; }
@@ -83,6 +119,15 @@ bool acceptAffine(Affine const & affine) { return true; }
 PYBIND11_MODULE(_tests, m) {
     cipells::wrapImageHelpers<float>(m);
     cipells::wrapImageHelpers<std::complex<float>>(m);
+    cipells::wrapImageHelpers<double>(m);
+    cipells::wrapImageHelpers<std::uint16_t>(m);
+    cipells::wrapImageHelpers<std::int32_t>(m);
+    cipells::wrapImageHelpers<cipells::Half>(m);
+    m.def("calibrateImage", &cipells::calibrateImage);
+    m.def("calibrateImageInto", &cipells::calibrateImageInto);
+    m.def("scaleRawImage", &cipells::scaleRawImage);
+    m.def("scaleRawImageLeft", &cipells::scaleRawImageLeft);
+    m.def("scaleFloatImage", &cipells::scaleFloatImage);
     m.def("acceptJacobian", &cipells::acceptJacobian);
     m.def("acceptTranslation", &cipells::acceptTranslation);
     m.def("acceptAffine", &cipells::acceptAffine);
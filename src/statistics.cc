@@ -0,0 +1,268 @@
+#define CIPELLS_statistics_cc_SRC
+
+#include <cmath>
+#include <limits>
+
+#include "cipells/statistics.h"
+#include "cipells/parallel.h"
+
+namespace cipells {
+
+namespace {
+
+constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+// Count, mean and sum of squared deviations of a set of values, which can
+// be combined with those of another set without loss of precision.
+struct MeanAccumulator {
+    Index count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min = INF;
+    double max = -INF;
+
+    template <typename Values>
+    static MeanAccumulator fromValues(Values const & values, Index count) {
+        MeanAccumulator result;
+        if (count > 0) {
+            result.count = count;
+            result.mean = values.sum()/count;
+        }
+        return result;
+    }
+
+    static MeanAccumulator combine(MeanAccumulator const & a, MeanAccumulator const & b) {
+        if (a.count == 0) {
+            return b;
+        }
+        if (b.count == 0) {
+            return a;
+        }
+        MeanAccumulator result;
+        result.count = a.count + b.count;
+        double delta = b.mean - a.mean;
+        result.mean = a.mean + delta*b.count/result.count;
+        result.m2 = a.m2 + b.m2 + delta*delta*a.count*b.count/result.count;
+        result.min = std::min(a.min, b.min);
+        result.max = std::max(a.max, b.max);
+        return result;
+    }
+
+    double variance() const { return count > 0 ? m2/count : NaN; }
+};
+
+// Flux-weighted sums of positions relative to a fixed origin.
+struct MomentAccumulator {
+    double s = 0.0;
+    double sx = 0.0;
+    double sy = 0.0;
+    double sxx = 0.0;
+    double sxy = 0.0;
+    double syy = 0.0;
+
+    static MomentAccumulator combine(MomentAccumulator const & a, MomentAccumulator const & b) {
+        MomentAccumulator result;
+        result.s = a.s + b.s;
+        result.sx = a.sx + b.sx;
+        result.sy = a.sy + b.sy;
+        result.sxx = a.sxx + b.sxx;
+        result.sxy = a.sxy + b.sxy;
+        result.syy = a.syy + b.syy;
+        return result;
+    }
+};
+
+template <typename Acc>
+Acc combinePairwise(std::vector<Acc> const & values, std::size_t begin, std::size_t end) {
+    if (end - begin == 0) {
+        return Acc();
+    }
+    if (end - begin == 1) {
+        return values[begin];
+    }
+    std::size_t mid = begin + (end - begin)/2;
+    return Acc::combine(combinePairwise(values, begin, mid), combinePairwise(values, mid, end));
+}
+
+// Compute an accumulator for each row of an image with
+// func(y, x, row), where row is an Eigen array expression of the pixel
+// values converted to double, and combine them pairwise.
+template <typename Acc, typename T, typename Func>
+Acc reduceRows(Image<T const> const & image, Func func) {
+    std::vector<Acc> rows(image.bbox().height());
+    Index const y0 = image.bbox().y0();
+    forEachRowBand(
+        image.bbox(),
+        [&image, &rows, &func, y0](IndexBox const & band) {
+            applyRows(
+                image[band],
+                [&rows, &func, y0](Index y, IndexInterval const & x, T const * row) {
+                    rows[y - y0] = func(
+                        y, x,
+                        Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1> const>(row, x.size()).template cast<double>()
+                    );
+                }
+            );
+        }
+    );
+    return combinePairwise(rows, 0, rows.size());
+}
+
+// Compute the statistics of the pixels with values in [lower, upper].
+template <typename T>
+MeanAccumulator accumulateValues(Image<T const> const & image, double lower=-INF, double upper=INF) {
+    bool const clipped = lower != -INF || upper != INF;
+    return reduceRows<MeanAccumulator>(
+        image,
+        [clipped, lower, upper](Index, IndexInterval const & x, auto const & values) {
+            if (!clipped) {
+                MeanAccumulator result = MeanAccumulator::fromValues(values, x.size());
+                result.m2 = (values - result.mean).square().sum();
+                result.min = values.minCoeff();
+                result.max = values.maxCoeff();
+                return result;
+            }
+            auto const in = (values >= lower && values <= upper);
+            MeanAccumulator result = MeanAccumulator::fromValues(in.select(values, 0.0), in.count());
+            if (result.count > 0) {
+                result.m2 = in.select(values - result.mean, 0.0).square().sum();
+                result.min = in.select(values, INF).minCoeff();
+                result.max = in.select(values, -INF).maxCoeff();
+            }
+            return result;
+        }
+    );
+}
+
+template <typename T>
+ImageMoments computeMomentsImpl(Image<T const> const & image) {
+    // Positions are measured from the center of the image, to limit
+    // round-off error in the second moments.
+    Real2 const origin = RealBox(image.bbox()).center();
+    MomentAccumulator sums = reduceRows<MomentAccumulator>(
+        image,
+        [&origin](Index y, IndexInterval const & x, auto const & values) {
+            auto const dx = Eigen::ArrayXd::LinSpaced(x.size(), x.min() - origin.x(), x.max() - origin.x());
+            double const dy = y - origin.y();
+            MomentAccumulator result;
+            result.s = values.sum();
+            result.sx = (values*dx).sum();
+            result.sxx = (values*dx.square()).sum();
+            result.sy = dy*result.s;
+            result.sxy = dy*result.sx;
+            result.syy = dy*result.sy;
+            return result;
+        }
+    );
+    ImageMoments result;
+    result.flux = sums.s;
+    double const cx = sums.sx/sums.s;
+    double const cy = sums.sy/sums.s;
+    result.centroid = Real2(origin.x() + cx, origin.y() + cy);
+    result.secondMoments(0, 0) = sums.sxx/sums.s - cx*cx;
+    result.secondMoments(0, 1) = result.secondMoments(1, 0) = sums.sxy/sums.s - cx*cy;
+    result.secondMoments(1, 1) = sums.syy/sums.s - cy*cy;
+    return result;
+}
+
+template <typename Result, typename T, typename Func>
+std::vector<Result> computeBatch(std::vector<Image<T const>> const & images, Func func) {
+    std::vector<Result> results(images.size());
+    detail::parallelFor(
+        images.size(),
+        [&images, &results, &func](Index i) { results[i] = func(images[i]); }
+    );
+    return results;
+}
+
+} // anonymous
+
+
+template <typename T>
+ImageStatistics computeStatistics(Image<T const> const & image) {
+    MeanAccumulator acc = accumulateValues(image);
+    ImageStatistics result;
+    result.count = acc.count;
+    result.sum = acc.mean*acc.count;
+    result.mean = acc.count > 0 ? acc.mean : NaN;
+    result.variance = acc.variance();
+    result.min = acc.count > 0 ? acc.min : NaN;
+    result.max = acc.count > 0 ? acc.max : NaN;
+    return result;
+}
+
+template <typename T>
+std::vector<ImageStatistics> computeStatistics(std::vector<Image<T const>> const & images) {
+    return computeBatch<ImageStatistics>(
+        images,
+        [](Image<T const> const & image) { return computeStatistics(image); }
+    );
+}
+
+template <typename T>
+ImageMoments computeMoments(Image<T const> const & image) {
+    return computeMomentsImpl(image);
+}
+
+template <typename T>
+std::vector<ImageMoments> computeMoments(std::vector<Image<T const>> const & images) {
+    return computeBatch<ImageMoments>(
+        images,
+        [](Image<T const> const & image) { return computeMoments(image); }
+    );
+}
+
+template <typename T>
+ClippedStatistics computeClippedStatistics(Image<T const> const & image, double nSigma, int maxIterations) {
+    MeanAccumulator acc = accumulateValues(image);
+    int iterations = 0;
+    while (iterations < maxIterations && acc.count > 0) {
+        double const limit = nSigma*std::sqrt(acc.variance());
+        MeanAccumulator clipped = accumulateValues(image, acc.mean - limit, acc.mean + limit);
+        ++iterations;
+        bool const converged = clipped.count == acc.count;
+        acc = clipped;
+        if (converged) {
+            break;
+        }
+    }
+    ClippedStatistics result;
+    result.count = acc.count;
+    result.mean = acc.count > 0 ? acc.mean : NaN;
+    result.stddev = std::sqrt(acc.variance());
+    result.iterations = iterations;
+    return result;
+}
+
+template <typename T>
+std::vector<ClippedStatistics> computeClippedStatistics(
+    std::vector<Image<T const>> const & images,
+    double nSigma,
+    int maxIterations
+) {
+    return computeBatch<ClippedStatistics>(
+        images,
+        [nSigma, maxIterations](Image<T const> const & image) {
+            return computeClippedStatistics(image, nSigma, maxIterations);
+        }
+    );
+}
+
+
+#define CIPELLS_STATISTICS_INSTANTIATE(T) \
+    template ImageStatistics computeStatistics(Image<T const> const &); \
+    template std::vector<ImageStatistics> computeStatistics(std::vector<Image<T const>> const &); \
+    template ImageMoments computeMoments(Image<T const> const &); \
+    template std::vector<ImageMoments> computeMoments(std::vector<Image<T const>> const &); \
+    template ClippedStatistics computeClippedStatistics(Image<T const> const &, double, int); \
+    template std::vector<ClippedStatistics> computeClippedStatistics( \
+        std::vector<Image<T const>> const &, double, int)
+
+CIPELLS_STATISTICS_INSTANTIATE(float);
+CIPELLS_STATISTICS_INSTANTIATE(double);
+CIPELLS_STATISTICS_INSTANTIATE(std::uint16_t);
+CIPELLS_STATISTICS_INSTANTIATE(std::int32_t);
+CIPELLS_STATISTICS_INSTANTIATE(Half);
+
+} // namespace cipells